@@ -0,0 +1,178 @@
+/***********************************************************************
+ * Implementation:
+ *    CHECKPOINT CACHE
+ * Summary:
+ *    Lookups share the lock, so readers never wait on each other; only
+ *    storing a checkpoint takes it alone. A lookup marks its checkpoint
+ *    as used with an atomic store, which it may do while sharing.
+ * Author
+ *    Matthew Burr, Shayla Nelson, Bryan Lopez, Kimberly Stowe
+ **********************************************************************/
+
+#include <cassert>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include "checkpointCache.h"
+#include "fibonacci.h"
+using namespace std;
+
+/************************************************
+ * CHECKPOINT CACHE :: CONSTRUCTOR
+ ***********************************************/
+CheckpointCache::CheckpointCache(uint64_t stride, size_t budget)
+   : checkpointStride(stride ? stride : 1), budget(budget), numBytes(0),
+     clock(0), numHits(0), numMisses(0), numEvictions(0)
+{
+}
+
+/************************************************
+ * CHECKPOINT CACHE :: SHARED
+ ***********************************************/
+CheckpointCache & CheckpointCache::shared()
+{
+   static CheckpointCache cache;
+   return cache;
+}
+
+/************************************************
+ * CHECKPOINT CACHE :: AT
+ ***********************************************/
+WholeNumber CheckpointCache::at(uint64_t n)
+{
+   WholeNumber current;
+   WholeNumber next;
+   pair(n, current, next);
+   return current;
+}
+
+/************************************************
+ * CHECKPOINT CACHE :: PAIR
+ * Two threads missing the same checkpoint will
+ * both work it out; the second store is ignored.
+ ***********************************************/
+void CheckpointCache::pair(uint64_t n, WholeNumber & current, WholeNumber & next)
+{
+   uint64_t below = n - n % checkpointStride;
+
+   uint64_t k = 0;
+   current = WholeNumber(0);
+   next = WholeNumber(1);
+
+   // below the first stride there is nothing worth keeping
+   if (below > 0)
+   {
+      if (find(n, k, current, next) && k == below)
+         numHits++;
+      else
+      {
+         numMisses++;
+         fibonacciAdvance(*this, k, below, current, next);
+         store(below, current, next);
+      }
+   }
+
+   fibonacciAdvance(*this, below, n, current, next);
+}
+
+/************************************************
+ * CHECKPOINT CACHE :: FIND
+ ***********************************************/
+bool CheckpointCache::find(uint64_t n, uint64_t & k, WholeNumber & current,
+                           WholeNumber & next, uint64_t least)
+{
+   shared_lock <shared_timed_mutex> guard(lock);
+
+   map <uint64_t, Checkpoint>::iterator it = checkpoints.upper_bound(n);
+   if (it == checkpoints.begin())
+      return false;
+   --it;
+   if (it->first < least)
+      return false;
+
+   k = it->first;
+   current = it->second.current;
+   next = it->second.next;
+   it->second.lastUsed.store(++clock);
+   return true;
+}
+
+/************************************************
+ * CHECKPOINT CACHE :: STORE
+ ***********************************************/
+void CheckpointCache::store(uint64_t k, const WholeNumber & current,
+                            const WholeNumber & next)
+{
+   assert(k % checkpointStride == 0);
+
+   // the limbs, and about what the map spends on a node
+   size_t bytes = (current.size() + next.size()) * sizeof(Limb)
+                + sizeof(Checkpoint) + 4 * sizeof(void *);
+   if (bytes > budget)
+      return;
+
+   unique_lock <shared_timed_mutex> guard(lock);
+   if (checkpoints.count(k))
+      return;
+
+   Checkpoint & checkpoint = checkpoints.emplace(piecewise_construct,
+                                                 forward_as_tuple(k),
+                                                 forward_as_tuple()).first->second;
+   checkpoint.current = current;
+   checkpoint.next = next;
+   checkpoint.bytes = bytes;
+   checkpoint.lastUsed.store(++clock);
+   numBytes += bytes;
+
+   evict();
+}
+
+/************************************************
+ * CHECKPOINT CACHE :: EVICT
+ * Looks through all of them for the oldest. There
+ * are few enough checkpoints in a budget that this
+ * costs nothing next to computing one.
+ ***********************************************/
+void CheckpointCache::evict()
+{
+   while (numBytes > budget && !checkpoints.empty())
+   {
+      map <uint64_t, Checkpoint>::iterator oldest = checkpoints.begin();
+      for (map <uint64_t, Checkpoint>::iterator it = checkpoints.begin();
+           it != checkpoints.end(); ++it)
+         if (it->second.lastUsed.load() < oldest->second.lastUsed.load())
+            oldest = it;
+
+      numBytes -= oldest->second.bytes;
+      checkpoints.erase(oldest);
+      numEvictions++;
+   }
+}
+
+/************************************************
+ * CHECKPOINT CACHE :: CLEAR
+ ***********************************************/
+void CheckpointCache::clear()
+{
+   unique_lock <shared_timed_mutex> guard(lock);
+   checkpoints.clear();
+   numBytes = 0;
+}
+
+/************************************************
+ * CHECKPOINT CACHE :: BYTES
+ ***********************************************/
+size_t CheckpointCache::bytes() const
+{
+   shared_lock <shared_timed_mutex> guard(lock);
+   return numBytes;
+}
+
+/************************************************
+ * CHECKPOINT CACHE :: SIZE
+ ***********************************************/
+size_t CheckpointCache::size() const
+{
+   shared_lock <shared_timed_mutex> guard(lock);
+   return checkpoints.size();
+}
@@ -0,0 +1,107 @@
+/***********************************************************************
+ * Header:
+ *    CHECKPOINT CACHE
+ * Summary:
+ *    Remembers F(k) and F(k+1) at every multiple k of a stride, so
+ *    that a query in a long-running process starts from the nearest
+ *    checkpoint at or below it instead of from F(0). The cache keeps
+ *    to a byte budget by dropping the checkpoint that was used longest
+ *    ago, and any number of threads may query it at once.
+ * Author
+ *    Matthew Burr, Shayla Nelson, Bryan Lopez, Kimberly Stowe
+ ************************************************************************/
+
+#ifndef CHECKPOINTCACHE_H
+#define CHECKPOINTCACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <shared_mutex>
+#include "wholeNumber.h"
+
+// checkpoints every this many indices, in at most this many bytes,
+// unless the cache is told otherwise
+#define CHECKPOINT_STRIDE 65536
+#define CHECKPOINT_BUDGET (64 * 1024 * 1024)
+
+/************************************************
+ * CHECKPOINT CACHE
+ ***********************************************/
+class CheckpointCache
+{
+public:
+   CheckpointCache(uint64_t stride = CHECKPOINT_STRIDE,
+                   size_t budget = CHECKPOINT_BUDGET);
+
+   // the cache the Fibonacci functions use, made on first use
+   static CheckpointCache & shared();
+
+   // F(n), from the nearest checkpoint at or below n. The checkpoint
+   // just below n is filled in if it was missing
+   WholeNumber at(uint64_t n);
+
+   // the same, ending with F(n + 1) as well
+   void pair(uint64_t n, WholeNumber & current, WholeNumber & next);
+
+   // the nearest checkpoint k at or below n, if there is one; with
+   // least given, only one at or above it counts
+   bool find(uint64_t n, uint64_t & k, WholeNumber & current,
+             WholeNumber & next, uint64_t least = 0);
+
+   // remembers F(k) and F(k + 1); k must be a multiple of the stride
+   void store(uint64_t k, const WholeNumber & current, const WholeNumber & next);
+
+   // forgets every checkpoint, keeping the counters
+   void clear();
+
+   // queries that found the checkpoint just below them, and ones that
+   // did not, and how many checkpoints were dropped to stay in budget
+   unsigned long hits()      const { return numHits.load();      }
+   unsigned long misses()    const { return numMisses.load();    }
+   unsigned long evictions() const { return numEvictions.load(); }
+   double hitRate() const
+   {
+      unsigned long total = hits() + misses();
+      return total ? (double)hits() / total : 0.0;
+   }
+
+   // what the cache holds now
+   size_t bytes() const;
+   size_t size() const;
+
+   uint64_t stride() const { return checkpointStride; }
+
+private:
+   struct Checkpoint
+   {
+      WholeNumber current;
+      WholeNumber next;
+      size_t bytes;
+      std::atomic <uint64_t> lastUsed;   // when, by the cache's clock
+   };
+
+   CheckpointCache(const CheckpointCache &);
+   CheckpointCache & operator = (const CheckpointCache &);
+
+   // drops the least recently used checkpoints until we are in budget;
+   // the lock must be held exclusively
+   void evict();
+
+   uint64_t checkpointStride;
+   size_t budget;
+
+   mutable std::shared_timed_mutex lock;
+   std::map <uint64_t, Checkpoint> checkpoints;
+   size_t numBytes;
+
+   // counts every use, so a smaller lastUsed means longer ago
+   std::atomic <uint64_t> clock;
+
+   std::atomic <unsigned long> numHits;
+   std::atomic <unsigned long> numMisses;
+   std::atomic <unsigned long> numEvictions;
+};
+
+#endif // CHECKPOINTCACHE_H
@@ -0,0 +1,335 @@
+/***********************************************************************
+ * Implementation:
+ *    CHECKPOINT TABLE
+ * Summary:
+ *    Writing, mapping and checking checkpoint files. Mapping uses mmap,
+ *    or a file mapping on Windows.
+ * Author
+ *    Matthew Burr, Shayla Nelson, Bryan Lopez, Kimberly Stowe
+ **********************************************************************/
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include "checkpointTable.h"
+#include "fibonacci.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+#define TABLE_MAGIC      "FIBTABLE"
+#define TABLE_VERSION    2
+#define TABLE_BYTE_ORDER 0x01020304
+
+static_assert(sizeof(TableHeader) == 64, "the header must be 64 bytes");
+static_assert(sizeof(TableEntry) == 16, "an index entry must be 16 bytes");
+
+/************************************************
+ * CHECKSUM MORE
+ * FNV-1a taken eight bytes at a time, carrying on
+ * from hash. Tail bytes are taken one at a time.
+ ***********************************************/
+static uint64_t checksumMore(uint64_t hash, const char * data, size_t size)
+{
+   const uint64_t prime = 0x100000001b3ULL;
+
+   size_t i = 0;
+   for (; i + 8 <= size; i += 8)
+   {
+      uint64_t word;
+      memcpy(&word, data + i, 8);
+      hash = (hash ^ word) * prime;
+   }
+   for (; i < size; i++)
+      hash = (hash ^ (unsigned char)data[i]) * prime;
+
+   return hash;
+}
+
+/************************************************
+ * CHECKPOINT TABLE :: CHECKSUM
+ ***********************************************/
+uint64_t CheckpointTable::checksum(const char * data, size_t size)
+{
+   return checksumMore(0xcbf29ce484222325ULL, data, size);
+}
+
+/************************************************
+ * TABLE CHECKSUM
+ * Carries the hash of everything after the header
+ * on over the header, with its checksum taken as
+ * zero. The header comes last because generate()
+ * only knows it once the limbs are written.
+ ***********************************************/
+static uint64_t tableChecksum(uint64_t bodyHash, const TableHeader & header)
+{
+   TableHeader hashed = header;
+   hashed.checksum = 0;
+   return checksumMore(bodyHash, reinterpret_cast <const char *>(&hashed),
+                       sizeof(hashed));
+}
+
+/************************************************
+ * CHECKPOINT TABLE :: CONSTRUCTOR
+ ***********************************************/
+CheckpointTable::CheckpointTable() : base(NULL), length(0), mapping(NULL)
+{
+}
+
+/************************************************
+ * CHECKPOINT TABLE :: OPEN
+ ***********************************************/
+void CheckpointTable::open(const char * fileName, bool verify) throw (const char *)
+{
+   close();
+
+#ifdef _WIN32
+   HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL,
+                             OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+   if (file == INVALID_HANDLE_VALUE)
+      throw "ERROR: unable to open the checkpoint table";
+
+   LARGE_INTEGER size;
+   if (!GetFileSizeEx(file, &size) || size.QuadPart < (LONGLONG)sizeof(TableHeader))
+   {
+      CloseHandle(file);
+      throw "ERROR: the checkpoint table is too short";
+   }
+
+   HANDLE map = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+   CloseHandle(file);
+   if (map == NULL)
+      throw "ERROR: unable to map the checkpoint table";
+
+   const void * view = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+   if (view == NULL)
+   {
+      CloseHandle(map);
+      throw "ERROR: unable to map the checkpoint table";
+   }
+
+   base = static_cast <const char *>(view);
+   length = (size_t)size.QuadPart;
+   mapping = map;
+#else
+   int file = ::open(fileName, O_RDONLY);
+   if (file < 0)
+      throw "ERROR: unable to open the checkpoint table";
+
+   struct stat status;
+   if (fstat(file, &status) != 0 || status.st_size < (off_t)sizeof(TableHeader))
+   {
+      ::close(file);
+      throw "ERROR: the checkpoint table is too short";
+   }
+
+   void * view = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_SHARED,
+                      file, 0);
+   ::close(file);
+   if (view == MAP_FAILED)
+      throw "ERROR: unable to map the checkpoint table";
+
+   base = static_cast <const char *>(view);
+   length = (size_t)status.st_size;
+   mapping = view;
+#endif
+
+   try
+   {
+      validate();
+      if (verify && tableChecksum(checksum(base + sizeof(TableHeader),
+                                           length - sizeof(TableHeader)),
+                                  header()) != header().checksum)
+         throw "ERROR: the checkpoint table does not match its checksum";
+   }
+   catch (const char *)
+   {
+      close();
+      throw;
+   }
+}
+
+/************************************************
+ * CHECKPOINT TABLE :: CLOSE
+ ***********************************************/
+void CheckpointTable::close()
+{
+   if (base == NULL)
+      return;
+
+#ifdef _WIN32
+   UnmapViewOfFile(base);
+   CloseHandle(static_cast <HANDLE>(mapping));
+#else
+   munmap(mapping, length);
+#endif
+
+   base = NULL;
+   length = 0;
+   mapping = NULL;
+}
+
+/************************************************
+ * CHECKPOINT TABLE :: VALIDATE
+ * Makes sure every entry points inside the file,
+ * so that a view can never read past the end
+ ***********************************************/
+void CheckpointTable::validate() const throw (const char *)
+{
+   const TableHeader & head = header();
+   if (memcmp(head.magic, TABLE_MAGIC, 8) != 0)
+      throw "ERROR: the file is not a checkpoint table";
+   if (head.version != TABLE_VERSION)
+      throw "ERROR: the checkpoint table is from a different version";
+   if (head.byteOrder != TABLE_BYTE_ORDER || head.limbBits != 32)
+      throw "ERROR: the checkpoint table was written by a different kind of machine";
+   if (head.fileSize != length)
+      throw "ERROR: the checkpoint table is the wrong size";
+   if (head.stride == 0 || head.count == 0)
+      throw "ERROR: the checkpoint table is empty";
+   if (head.indexOffset < sizeof(TableHeader) || head.indexOffset > length ||
+       head.indexOffset % 8 != 0 ||
+       (length - head.indexOffset) / sizeof(TableEntry) != head.count ||
+       (length - head.indexOffset) % sizeof(TableEntry) != 0)
+      throw "ERROR: the checkpoint table index is damaged";
+   if ((head.count - 1) > UINT64_MAX / head.stride)
+      throw "ERROR: the checkpoint table runs past the largest index";
+
+   for (uint64_t i = 0; i < head.count; i++)
+   {
+      const TableEntry & item = entry(i);
+      uint64_t limbs = (uint64_t)item.currentSize + item.nextSize;
+      if (item.offset < sizeof(TableHeader) || item.offset % sizeof(Limb) != 0 ||
+          item.currentSize == 0 || item.nextSize == 0 ||
+          item.offset > head.indexOffset ||
+          limbs > (head.indexOffset - item.offset) / sizeof(Limb))
+         throw "ERROR: the checkpoint table index is damaged";
+   }
+}
+
+/************************************************
+ * CHECKPOINT TABLE :: CURRENT
+ ***********************************************/
+WholeNumberView CheckpointTable::current(uint64_t i) const
+{
+   assert(isOpen() && i < count());
+   const TableEntry & item = entry(i);
+   return WholeNumberView(reinterpret_cast <const Limb *>(base + item.offset),
+                          item.currentSize);
+}
+
+/************************************************
+ * CHECKPOINT TABLE :: NEXT
+ ***********************************************/
+WholeNumberView CheckpointTable::next(uint64_t i) const
+{
+   assert(isOpen() && i < count());
+   const TableEntry & item = entry(i);
+   return WholeNumberView(reinterpret_cast <const Limb *>(base + item.offset) +
+                          item.currentSize, item.nextSize);
+}
+
+/************************************************
+ * CHECKPOINT TABLE :: FIND
+ ***********************************************/
+void CheckpointTable::find(uint64_t n, uint64_t & k, WholeNumber & current,
+                           WholeNumber & next) const
+{
+   uint64_t i = min(n / stride(), count() - 1);
+   k = i * stride();
+   current = WholeNumber(this->current(i));
+   next = WholeNumber(this->next(i));
+}
+
+/************************************************
+ * CHECKPOINT TABLE :: AT
+ ***********************************************/
+WholeNumber CheckpointTable::at(uint64_t n) const
+{
+   uint64_t k;
+   WholeNumber current;
+   WholeNumber next;
+   find(n, k, current, next);
+   fibonacciAdvance(k, n, current, next);
+   return current;
+}
+
+/************************************************
+ * CHECKPOINT TABLE :: GENERATE
+ * The limbs go out as each checkpoint is found,
+ * so only the index is held in memory. The header
+ * is written last, once the checksum is known.
+ ***********************************************/
+void CheckpointTable::generate(const char * fileName, uint64_t stride,
+                               uint64_t count) throw (const char *)
+{
+   if (stride == 0 || count == 0)
+      throw "ERROR: a checkpoint table needs a stride and at least one checkpoint";
+   if (count - 1 > (UINT64_MAX - 1) / stride)
+      throw "ERROR: the checkpoint table would run past the largest index";
+
+   ofstream file(fileName, ios::out | ios::binary | ios::trunc);
+   if (!file)
+      throw "ERROR: unable to create the checkpoint table";
+
+   TableHeader head;
+   memset(&head, 0, sizeof(head));
+   file.write(reinterpret_cast <const char *>(&head), sizeof(head));
+
+   uint64_t hash = checksum(NULL, 0);
+   uint64_t offset = sizeof(head);
+   vector <TableEntry> index(count);
+   vector <Limb> limbs;
+
+   WholeNumber a(0);   // F(k)
+   WholeNumber b(1);   // F(k+1)
+   for (uint64_t i = 0; i < count; i++)
+   {
+      if (i > 0)
+         fibonacciAdvance((i - 1) * stride, i * stride, a, b);
+
+      // both numbers together, padded to keep the next pair aligned
+      limbs.assign(a.limbs(), a.limbs() + a.size());
+      limbs.insert(limbs.end(), b.limbs(), b.limbs() + b.size());
+      if (limbs.size() % 2)
+         limbs.push_back(0);
+
+      index[i].offset = offset;
+      index[i].currentSize = (uint32_t)a.size();
+      index[i].nextSize = (uint32_t)b.size();
+
+      size_t bytes = limbs.size() * sizeof(Limb);
+      file.write(reinterpret_cast <const char *>(&limbs[0]), bytes);
+      hash = checksumMore(hash, reinterpret_cast <const char *>(&limbs[0]), bytes);
+      offset += bytes;
+   }
+
+   size_t indexBytes = index.size() * sizeof(TableEntry);
+   file.write(reinterpret_cast <const char *>(&index[0]), indexBytes);
+   hash = checksumMore(hash, reinterpret_cast <const char *>(&index[0]), indexBytes);
+
+   memcpy(head.magic, TABLE_MAGIC, 8);
+   head.version = TABLE_VERSION;
+   head.byteOrder = TABLE_BYTE_ORDER;
+   head.limbBits = 32;
+   head.stride = stride;
+   head.count = count;
+   head.indexOffset = offset;
+   head.fileSize = offset + indexBytes;
+   head.checksum = tableChecksum(hash, head);
+   file.seekp(0);
+   file.write(reinterpret_cast <const char *>(&head), sizeof(head));
+
+   file.close();
+   if (!file)
+      throw "ERROR: unable to write the checkpoint table";
+}
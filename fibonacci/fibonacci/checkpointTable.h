@@ -0,0 +1,118 @@
+/***********************************************************************
+ * Header:
+ *    CHECKPOINT TABLE
+ * Summary:
+ *    F(k) and F(k+1) for k = 0, stride, 2 stride, ..., worked out once
+ *    and saved in a file that later runs map into memory. Nothing is
+ *    parsed when the file is opened: the limbs sit in the file exactly
+ *    as they do in memory, and WholeNumberViews read them in place.
+ *
+ *    The file, all in this machine's byte order:
+ *       header    64 bytes, described by TableHeader
+ *       limbs     each checkpoint's two numbers, 8-byte aligned
+ *       index     a TableEntry per checkpoint saying where they are
+ *    The checksum covers everything after the header, and then the
+ *    header itself with the checksum taken as zero.
+ * Author
+ *    Matthew Burr, Shayla Nelson, Bryan Lopez, Kimberly Stowe
+ ************************************************************************/
+
+#ifndef CHECKPOINTTABLE_H
+#define CHECKPOINTTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include "wholeNumber.h"
+
+/************************************************
+ * TABLE HEADER
+ * The first 64 bytes of a checkpoint file
+ ***********************************************/
+struct TableHeader
+{
+   char     magic[8];       // "FIBTABLE"
+   uint32_t version;        // 2
+   uint32_t byteOrder;      // 0x01020304 as this machine writes it
+   uint32_t limbBits;       // 32
+   uint32_t reserved;
+   uint64_t stride;         // between checkpoints
+   uint64_t count;          // how many checkpoints, starting from 0
+   uint64_t indexOffset;    // where the TableEntries start
+   uint64_t fileSize;
+   uint64_t checksum;       // of the rest of the file, then the header
+};
+
+/************************************************
+ * TABLE ENTRY
+ * Where one checkpoint's limbs are. The limbs of
+ * F(k+1) follow right after the limbs of F(k).
+ ***********************************************/
+struct TableEntry
+{
+   uint64_t offset;         // from the start of the file
+   uint32_t currentSize;    // limbs in F(k)
+   uint32_t nextSize;       // limbs in F(k+1)
+};
+
+/************************************************
+ * CHECKPOINT TABLE
+ ***********************************************/
+class CheckpointTable
+{
+public:
+   CheckpointTable();
+   ~CheckpointTable() { close(); }
+
+   // maps a table file, checking its header and index, and if asked,
+   // its checksum. Throws if the file is not a good table
+   void open(const char * fileName, bool verify = true) throw (const char *);
+
+   // unmaps the file; views into it are no longer good
+   void close();
+
+   bool     isOpen() const { return base != NULL;       }
+   uint64_t stride() const { return header().stride;    }
+   uint64_t count()  const { return header().count;     }
+
+   // F(k) and F(k + 1) for the ith checkpoint, k = i stride, in place
+   WholeNumberView current(uint64_t i) const;
+   WholeNumberView next(uint64_t i) const;
+
+   // F(n), starting from the nearest checkpoint at or below n
+   WholeNumber at(uint64_t n) const;
+
+   // the nearest checkpoint k at or below n, copied out
+   void find(uint64_t n, uint64_t & k, WholeNumber & current,
+             WholeNumber & next) const;
+
+   // writes a table of count checkpoints, stride apart
+   static void generate(const char * fileName, uint64_t stride,
+                        uint64_t count) throw (const char *);
+
+   // the checksum the header holds, over size bytes
+   static uint64_t checksum(const char * data, size_t size);
+
+private:
+   CheckpointTable(const CheckpointTable &);
+   CheckpointTable & operator = (const CheckpointTable &);
+
+   const TableHeader & header() const
+   {
+      return *reinterpret_cast <const TableHeader *>(base);
+   }
+
+   const TableEntry & entry(uint64_t i) const
+   {
+      return reinterpret_cast <const TableEntry *>
+         (base + header().indexOffset)[i];
+   }
+
+   // checks everything but the checksum, throwing at the first problem
+   void validate() const throw (const char *);
+
+   const char * base;       // the mapped file
+   size_t length;
+   void * mapping;          // what the system needs to unmap it
+};
+
+#endif // CHECKPOINTTABLE_H
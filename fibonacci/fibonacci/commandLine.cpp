@@ -0,0 +1,607 @@
+/***********************************************************************
+ * Implementation:
+ *    COMMAND LINE
+ * Summary:
+ *    Reads the arguments into a list of requests, then writes each
+ *    Fibonacci number asked for to standard out or to a file. Output
+ *    goes through reused strings, a range's in chunks written by all
+ *    the threads at once, and is flushed once at the end.
+ * Author
+ *    Matthew Burr, Shayla Nelson, Bryan Lopez, Kimberly Stowe
+ **********************************************************************/
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "checkpointCache.h"
+#include "checkpointTable.h"
+#include "commandLine.h"
+#include "fibonacci.h"
+#include "fibonacciDigits.h"
+#include "runState.h"
+#include "threadPool.h"
+using namespace std;
+
+// characters a buffer of range output holds before it is written
+#define RANGE_TEXT (1 << 22)
+
+// a chunk of a range is never cut smaller than this many numbers
+// unless they do not fit in a buffer, since each one seeds itself
+#define RANGE_MIN_TERMS 16
+
+// what a request wants to know about F(last), if not the whole number
+enum Query
+{
+   QUERY_NUMBER,        // all of its digits
+   QUERY_DIGIT_COUNT,   // how many digits it has
+   QUERY_LEADING,       // its first count digits
+   QUERY_TRAILING,      // its last count digits
+   QUERY_INDEX_OF       // which n has F(n) equal to each of numbers
+};
+
+/************************************************
+ * REQUEST
+ * F(first) through F(last), one per line, or
+ * if there are any indices, F(n) for each of them.
+ * A sequential request adds its way up to F(last)
+ * and can be stopped and resumed. A query answers
+ * something about F(last) without finding it.
+ ***********************************************/
+struct Request
+{
+   Request() : first(0), last(0), sequential(false), query(QUERY_NUMBER),
+               count(0), operand(NULL) { }
+
+   uint64_t first;
+   uint64_t last;
+   vector <uint64_t> indices;
+   bool sequential;
+   Query query;
+   unsigned count;
+   const char * operand;         // what --index-of was given
+   vector <WholeNumber> numbers;
+};
+
+/************************************************
+ * USAGE
+ ***********************************************/
+static void usage(ostream & out)
+{
+   out << "Usage: a.out [--index N] [--range A B] [--count N]\n"
+       << "             [--batch FILE] [--threads N] [--table FILE]\n"
+       << "             [--make-table FILE [--stride S] [--checkpoints N]]\n"
+       << "             [--sequential N --state FILE [--every-steps S]\n"
+       << "              [--every-seconds T] [--resume]]\n"
+       << "             [--digit-count N] [--leading N K] [--trailing N K]\n"
+       << "             [--index-of X]\n"
+       << "             [--format plain|commas|hex] [--output FILE]\n"
+       << "\t--index N    the Nth Fibonacci number\n"
+       << "\t--range A B  the Ath through the Bth\n"
+       << "\t--count N    the first N, starting from F(1)\n"
+       << "\t--batch FILE one for each index in FILE, or - for the keyboard\n"
+       << "\t--threads N  threads for --batch and --range, one per core by default\n"
+       << "\t--table FILE start from the checkpoints in FILE\n"
+       << "\t--sequential N  F(N) one step at a time, saving to --state FILE\n"
+       << "\t             every --every-steps S or --every-seconds T (60)\n"
+       << "\t--resume     carry on from --state FILE if it is there\n"
+       << "\t--digit-count N  how many digits the Nth has\n"
+       << "\t--leading N K  its first K digits, up to 100\n"
+       << "\t--trailing N K its last K digits, up to 27\n"
+       << "\t--index-of X which Fibonacci number X is, or none; - reads\n"
+       << "\t             numbers from the keyboard\n"
+       << "\t--make-table FILE  write --checkpoints N checkpoints, --stride S\n"
+       << "\t             apart, to FILE (64 and 65536 by default)\n"
+       << "\t--format     how the digits are written, commas by default\n"
+       << "\t--output     write to FILE instead of the screen\n"
+       << "With no arguments the test menu comes up instead.\n";
+}
+
+/************************************************
+ * PARSE INDEX
+ * A whole number, and nothing after it
+ ***********************************************/
+static uint64_t parseIndex(const char * text) throw (const char *)
+{
+   if (text == NULL || *text < '0' || *text > '9')
+      throw "ERROR: expected a whole number";
+
+   char * end;
+   errno = 0;
+   unsigned long long value = strtoull(text, &end, 10);
+   if (*end != '\0')
+      throw "ERROR: expected a whole number";
+   if (errno == ERANGE)
+      throw "ERROR: the number is too large";
+
+   return (uint64_t)value;
+}
+
+/************************************************
+ * PARSE FORMAT
+ ***********************************************/
+static DigitFormat parseFormat(const char * text) throw (const char *)
+{
+   if (text == NULL)
+      throw "ERROR: --format needs plain, commas or hex";
+   if (strcmp(text, "plain") == 0)
+      return DIGITS_PLAIN;
+   if (strcmp(text, "commas") == 0)
+      return DIGITS_COMMAS;
+   if (strcmp(text, "hex") == 0)
+      return DIGITS_HEX;
+   throw "ERROR: --format needs plain, commas or hex";
+}
+
+/************************************************
+ * READ INDICES
+ * Whole numbers separated by white space
+ ***********************************************/
+static void readIndices(const char * fileName, vector <uint64_t> & indices)
+   throw (const char *)
+{
+   if (fileName == NULL)
+      throw "ERROR: --batch needs a file name";
+
+   ifstream file;
+   bool keyboard = strcmp(fileName, "-") == 0;
+   if (!keyboard)
+   {
+      file.open(fileName);
+      if (!file)
+         throw "ERROR: unable to open the batch file";
+   }
+   istream & in = keyboard ? cin : static_cast <istream &>(file);
+
+   string word;
+   while (in >> word)
+      indices.push_back(parseIndex(word.c_str()));
+}
+
+/************************************************
+ * PARSE QUERY
+ * --leading N K or --trailing N K
+ ***********************************************/
+static Request parseQuery(Query query, const char * index, const char * count,
+                          unsigned most) throw (const char *)
+{
+   Request request;
+   request.first = request.last = parseIndex(index);
+   request.query = query;
+
+   uint64_t digits = parseIndex(count);
+   if (digits == 0 || digits > most)
+      throw query == QUERY_LEADING ? "ERROR: --leading needs 1 to 100 digits"
+                                   : "ERROR: --trailing needs 1 to 27 digits";
+   request.count = (unsigned)digits;
+   return request;
+}
+
+/************************************************
+ * READ NUMBERS
+ * The number given, or if it is -, whole numbers
+ * separated by white space from the keyboard
+ ***********************************************/
+static void readNumbers(const char * value, vector <WholeNumber> & numbers)
+   throw (const char *)
+{
+   if (value == NULL)
+      throw "ERROR: --index-of needs a number";
+   if (strcmp(value, "-") != 0)
+   {
+      numbers.push_back(parseWholeNumber(value));
+      return;
+   }
+
+   string word;
+   while (cin >> word)
+      numbers.push_back(parseWholeNumber(word));
+}
+
+/************************************************
+ * WRITE QUERY
+ ***********************************************/
+static void writeQuery(ostream & out, const Request & request, string & text)
+{
+   uint64_t n;
+   switch (request.query)
+   {
+      case QUERY_INDEX_OF:
+         for (size_t i = 0; i < request.numbers.size(); i++)
+         {
+            text = fibonacciIndexOf(request.numbers[i], n) ? to_string(n)
+                                                            : "none";
+            text += '\n';
+            out.write(text.data(), text.size());
+         }
+         return;
+      case QUERY_DIGIT_COUNT:
+         text = to_string(fibonacciDigitCount(request.last));
+         break;
+      case QUERY_LEADING:
+         text = fibonacciLeadingDigits(request.last, request.count);
+         break;
+      default:
+         text = fibonacciTrailingDigits(request.last, request.count);
+   }
+   text += '\n';
+   out.write(text.data(), text.size());
+}
+
+/************************************************
+ * WRITE BATCH
+ ***********************************************/
+static void writeBatch(ostream & out, const Request & request,
+                       DigitFormat format, string & text)
+{
+   vector <WholeNumber> results = fibonacciBatch(request.indices);
+   for (size_t i = 0; i < results.size(); i++)
+   {
+      results[i].toString(text, format);
+      text += '\n';
+      out.write(text.data(), text.size());
+   }
+}
+
+/************************************************
+ * TEXT PER TERM
+ * About how many characters F(n) takes, with room
+ * for commas: it has n log10(phi) digits
+ ***********************************************/
+static double textPerTerm(uint64_t n)
+{
+   return (double)n * 0.20898764024997873 * 4.0 / 3.0 + 2.0;
+}
+
+/************************************************
+ * SEED
+ * F(k) and F(k + 1) directly, or from the table
+ * if there is one
+ ***********************************************/
+static void seed(uint64_t k, const CheckpointTable & table,
+                 WholeNumber & a, WholeNumber & b)
+{
+   if (table.isOpen())
+   {
+      uint64_t start;
+      table.find(k, start, a, b);
+      fibonacciAdvance(start, k, a, b);
+   }
+   else
+      fibonacciPair(k, a, b);
+}
+
+/************************************************
+ * WRITE CHUNK
+ * F(first) through F(last) into out, one per
+ * line, leaving a and b at F(last + 1) and
+ * F(last + 2) for whoever carries on from here
+ ***********************************************/
+static void writeChunk(uint64_t first, uint64_t last, WholeNumber & a,
+                       WholeNumber & b, DigitFormat format, string & out,
+                       string & text)
+{
+   out.clear();
+   for (uint64_t n = first; ; n++)
+   {
+      a.toString(text, format);
+      out += text;
+      out += '\n';
+
+      a += b;
+      swap(a, b);
+
+      if (n == last)
+         break;
+   }
+}
+
+/************************************************
+ * WRITE RANGE
+ * The range goes out in rounds. Each round is
+ * cut into one chunk per thread, every chunk is
+ * written into its own buffer in parallel, and
+ * the buffers then go out in order. The first
+ * chunk of a round carries on from where the last
+ * one before it stopped; the others seed their own
+ * F(k), F(k + 1). A buffer holds about RANGE_TEXT
+ * characters, so memory stays bounded however
+ * wide the range is.
+ ***********************************************/
+static void writeRange(ostream & out, const Request & request,
+                       const CheckpointTable & table, DigitFormat format)
+{
+   ThreadPool & pool = ThreadPool::shared();
+   size_t chunks = pool.size() ? pool.size() : 1;
+
+   vector <WholeNumber> a(chunks);
+   vector <WholeNumber> b(chunks);
+   vector <string> buffers(chunks);
+   vector <string> texts(chunks);
+   vector <uint64_t> firsts(chunks);
+   vector <uint64_t> lasts(chunks);
+
+   seed(request.first, table, a[0], b[0]);
+
+   uint64_t next = request.first;   // the first index not yet written
+   bool more = true;
+   while (more)
+   {
+      // chunks that fit in a buffer, but no smaller than they must be
+      // to share out what is left
+      uint64_t terms = (uint64_t)(RANGE_TEXT / textPerTerm(request.last));
+      uint64_t share = (request.last - next) / chunks + 1;
+      terms = max <uint64_t>(1, min(terms, max <uint64_t>(share, RANGE_MIN_TERMS)));
+
+      size_t used = 0;
+      while (more && used < chunks)
+      {
+         firsts[used] = next;
+         lasts[used] = request.last - next < terms ? request.last
+                                                   : next + terms - 1;
+         more = lasts[used] != request.last;
+         next = lasts[used] + 1;
+         used++;
+      }
+
+      TaskGroup group;
+      for (size_t c = 0; c < used; c++)
+         pool.run(group, [&, c]
+         {
+            if (c > 0)
+               seed(firsts[c], table, a[c], b[c]);
+            writeChunk(firsts[c], lasts[c], a[c], b[c], format,
+                       buffers[c], texts[c]);
+         });
+      pool.wait(group);
+
+      for (size_t c = 0; c < used; c++)
+         out.write(buffers[c].data(), buffers[c].size());
+
+      // the next round starts where the last chunk stopped
+      swap(a[0], a[used - 1]);
+      swap(b[0], b[used - 1]);
+   }
+}
+
+/************************************************
+ * FIBONACCI COMMAND LINE
+ * Every argument is checked before anything is
+ * written, so a typo at the end does not leave
+ * half a file behind
+ ***********************************************/
+int fibonacciCommandLine(int argc, const char * argv[])
+{
+   try
+   {
+      vector <Request> requests;
+      DigitFormat format = DIGITS_COMMAS;
+      const char * fileName = NULL;
+      const char * tableName = NULL;       // to read checkpoints from
+      const char * newTableName = NULL;    // to write checkpoints to
+      uint64_t stride = CHECKPOINT_STRIDE;
+      uint64_t checkpoints = 64;
+      RunOptions run;
+
+      for (int i = 1; i < argc; i++)
+      {
+         const char * option = argv[i];
+         const char * value = i + 1 < argc ? argv[i + 1] : NULL;
+
+         if (strcmp(option, "--index") == 0)
+         {
+            Request request;
+            request.first = request.last = parseIndex(value);
+            requests.push_back(request);
+            i++;
+         }
+         else if (strcmp(option, "--range") == 0)
+         {
+            Request request;
+            request.first = parseIndex(value);
+            request.last = parseIndex(i + 2 < argc ? argv[i + 2] : NULL);
+            if (request.last < request.first)
+               throw "ERROR: --range must not run backwards";
+            requests.push_back(request);
+            i += 2;
+         }
+         else if (strcmp(option, "--count") == 0)
+         {
+            uint64_t count = parseIndex(value);
+            if (count > 0)
+            {
+               Request request;
+               request.first = 1;
+               request.last = count;
+               requests.push_back(request);
+            }
+            i++;
+         }
+         else if (strcmp(option, "--batch") == 0)
+         {
+            Request request;
+            readIndices(value, request.indices);
+            if (!request.indices.empty())
+               requests.push_back(request);
+            i++;
+         }
+         else if (strcmp(option, "--threads") == 0)
+         {
+            ThreadPool::setSharedSize((unsigned)parseIndex(value));
+            i++;
+         }
+         else if (strcmp(option, "--format") == 0)
+         {
+            format = parseFormat(value);
+            i++;
+         }
+         else if (strcmp(option, "--output") == 0)
+         {
+            if (value == NULL)
+               throw "ERROR: --output needs a file name";
+            fileName = value;
+            i++;
+         }
+         else if (strcmp(option, "--table") == 0)
+         {
+            if (value == NULL)
+               throw "ERROR: --table needs a file name";
+            tableName = value;
+            i++;
+         }
+         else if (strcmp(option, "--make-table") == 0)
+         {
+            if (value == NULL)
+               throw "ERROR: --make-table needs a file name";
+            newTableName = value;
+            i++;
+         }
+         else if (strcmp(option, "--stride") == 0)
+         {
+            stride = parseIndex(value);
+            if (stride == 0)
+               throw "ERROR: --stride must be at least 1";
+            i++;
+         }
+         else if (strcmp(option, "--checkpoints") == 0)
+         {
+            checkpoints = parseIndex(value);
+            if (checkpoints == 0)
+               throw "ERROR: --checkpoints must be at least 1";
+            i++;
+         }
+         else if (strcmp(option, "--sequential") == 0)
+         {
+            Request request;
+            request.first = request.last = parseIndex(value);
+            request.sequential = true;
+            requests.push_back(request);
+            i++;
+         }
+         else if (strcmp(option, "--digit-count") == 0)
+         {
+            Request request;
+            request.first = request.last = parseIndex(value);
+            request.query = QUERY_DIGIT_COUNT;
+            requests.push_back(request);
+            i++;
+         }
+         else if (strcmp(option, "--leading") == 0)
+         {
+            requests.push_back(parseQuery(QUERY_LEADING, value,
+                                          i + 2 < argc ? argv[i + 2] : NULL,
+                                          LEADING_DIGITS_MOST));
+            i += 2;
+         }
+         else if (strcmp(option, "--trailing") == 0)
+         {
+            requests.push_back(parseQuery(QUERY_TRAILING, value,
+                                          i + 2 < argc ? argv[i + 2] : NULL,
+                                          TRAILING_DIGITS_MOST));
+            i += 2;
+         }
+         else if (strcmp(option, "--index-of") == 0)
+         {
+            Request request;
+            request.query = QUERY_INDEX_OF;
+            request.operand = value;
+            requests.push_back(request);
+            i++;
+         }
+         else if (strcmp(option, "--state") == 0)
+         {
+            if (value == NULL)
+               throw "ERROR: --state needs a file name";
+            run.fileName = value;
+            i++;
+         }
+         else if (strcmp(option, "--every-steps") == 0)
+         {
+            run.everySteps = parseIndex(value);
+            i++;
+         }
+         else if (strcmp(option, "--every-seconds") == 0)
+         {
+            run.everySeconds = (double)parseIndex(value);
+            i++;
+         }
+         else if (strcmp(option, "--resume") == 0)
+            run.resume = true;
+         else if (strcmp(option, "--help") == 0)
+         {
+            usage(cout);
+            return 0;
+         }
+         else
+         {
+            usage(cerr);
+            throw "ERROR: unrecognized argument";
+         }
+      }
+
+      if (run.resume && run.fileName == NULL)
+         throw "ERROR: --resume needs --state FILE";
+      for (size_t i = 0; i < requests.size(); i++)
+         if (requests[i].sequential && run.fileName == NULL)
+         {
+            usage(cerr);
+            throw "ERROR: --sequential needs --state FILE";
+         }
+
+      // reading a long number multiplies, which starts the shared pool,
+      // so the numbers wait until --threads has had its say
+      for (size_t i = 0; i < requests.size(); i++)
+         if (requests[i].query == QUERY_INDEX_OF)
+            readNumbers(requests[i].operand, requests[i].numbers);
+
+      // we never mix cout with printf, so it may keep its own buffer
+      ios_base::sync_with_stdio(false);
+
+      // a new table first, so that it can be used right away
+      if (newTableName)
+         CheckpointTable::generate(newTableName, stride, checkpoints);
+
+      CheckpointTable table;
+      if (tableName)
+         table.open(tableName);
+
+      ofstream file;
+      if (fileName)
+      {
+         file.open(fileName);
+         if (!file)
+            throw "ERROR: unable to open the output file";
+      }
+      ostream & out = fileName ? static_cast <ostream &>(file) : cout;
+
+      string text;
+      for (size_t i = 0; i < requests.size(); i++)
+         if (requests[i].sequential)
+         {
+            fibonacciResumable(requests[i].last, run).toString(text, format);
+            text += '\n';
+            out.write(text.data(), text.size());
+         }
+         else if (requests[i].query != QUERY_NUMBER)
+            writeQuery(out, requests[i], text);
+         else if (requests[i].indices.empty())
+            writeRange(out, requests[i], table, format);
+         else
+            writeBatch(out, requests[i], format, text);
+
+      out.flush();
+      if (!out)
+         throw "ERROR: unable to write the output";
+   }
+   catch (const char * error)
+   {
+      cerr << error << '\n';
+      return 1;
+   }
+
+   return 0;
+}
@@ -0,0 +1,33 @@
+/***********************************************************************
+ * Header:
+ *    COMMAND LINE
+ * Summary:
+ *    Runs the Fibonacci program from its arguments instead of the menu,
+ *    so it can be scripted:
+ *       a.out --index N             F(N)
+ *       a.out --range A B           F(A) through F(B)
+ *       a.out --count N             F(1) through F(N), as the menu does
+ *       a.out --batch FILE          F(n) for each n listed in FILE
+ *       a.out --threads N           how many threads a batch or range uses
+ *       a.out --table FILE          start from a checkpoint table
+ *       a.out --make-table FILE --stride S --checkpoints N
+ *       a.out --sequential N --state FILE [--resume]
+ *             [--every-steps S] [--every-seconds T]
+ *       a.out --digit-count N       how many digits F(N) has
+ *       a.out --leading N K         the first K digits of F(N)
+ *       a.out --trailing N K        the last K digits of F(N)
+ *       a.out --index-of X          the n with F(n) = X, if there is one
+ *       a.out --format plain|commas|hex
+ *       a.out --output FILE
+ *    There are no prompts, and each number goes on its own line.
+ * Author
+ *    Matthew Burr, Shayla Nelson, Bryan Lopez, Kimberly Stowe
+ ************************************************************************/
+
+#ifndef COMMANDLINE_H
+#define COMMANDLINE_H
+
+// runs the requests in argv, returning the exit status for main()
+int fibonacciCommandLine(int argc, const char * argv[]);
+
+#endif // COMMANDLINE_H
@@ -8,11 +8,391 @@
  *    Matthew Burr, Shayla Nelson, Bryan Lopez, Kimberly Stowe
  **********************************************************************/
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 #include <iostream>
+#include "checkpointCache.h"
 #include "fibonacci.h"   // for fibonacci() prototype
+#include "fibonacciMod.h"
+#include "threadPool.h"
 #include "wholeNumber.h"
 using namespace std;
 
+/************************************************
+ * FIBONACCI AT
+ * Finds the nth Fibonacci number by fast doubling.
+ * Given F(k) and F(k+1) we get
+ *    F(2k)   = F(k+1)^2 - (F(k+1) - F(k))^2
+ *    F(2k+1) = F(k)^2 + F(k+1)^2
+ * so walking the bits of n from the top takes
+ * O(log n) steps instead of n additions, and each
+ * step is three squares, which are cheaper than
+ * general products. Past the table it goes through
+ * the shared checkpoint cache, so a query near one
+ * asked before starts from where that one passed.
+ ***********************************************/
+WholeNumber fibonacciAt(uint64_t n)
+{
+   if (n < FIBONACCI_TABLE_SIZE)
+      return WholeNumber(FIBONACCI_TABLE[n]);
+
+   return CheckpointCache::shared().at(n);
+}
+
+/************************************************
+ * FIBONACCI PAIR
+ * The doubling loop behind fibonacciAt, which
+ * ends with F(n + 1) as well as F(n). Rather than
+ * from k = 0, it starts from the longest run of
+ * n's top bits whose pair is in the table, then
+ * doubles in 128-bit numbers while the pair still
+ * fits, so WholeNumbers only come in after that.
+ ***********************************************/
+void fibonacciPair(uint64_t n, WholeNumber & a, WholeNumber & b)
+{
+   // the top bits of n, k = n >> bit, with F(k + 1) in the table
+   int bit = 64;
+   while (bit > 0 && (n >> (bit - 1)) + 1 < FIBONACCI_TABLE_SIZE)
+      --bit;
+   uint64_t k = bit < 64 ? n >> bit : 0;
+
+#ifdef __SIZEOF_INT128__
+   // F(187) is the first Fibonacci number past 2^128
+   unsigned __int128 small = FIBONACCI_TABLE[k];       // F(k)
+   unsigned __int128 smallNext = FIBONACCI_TABLE[k + 1];
+   for (; bit > 0 && 2 * k + 2 < 187; --bit)
+   {
+      // F(2k) = F(k) (2 F(k+1) - F(k)), F(2k+1) = F(k)^2 + F(k+1)^2
+      unsigned __int128 even = small * (2 * smallNext - small);
+      unsigned __int128 odd = small * small + smallNext * smallNext;
+      if ((n >> (bit - 1)) & 1)
+      {
+         small = odd;
+         smallNext = even + odd;
+         k = 2 * k + 1;
+      }
+      else
+      {
+         small = even;
+         smallNext = odd;
+         k = 2 * k;
+      }
+   }
+   a = WholeNumber(small);       // F(k)
+   b = WholeNumber(smallNext);   // F(k+1)
+#else
+   a = WholeNumber(FIBONACCI_TABLE[k]);       // F(k)
+   b = WholeNumber(FIBONACCI_TABLE[k + 1]);   // F(k+1)
+#endif
+   WholeNumber gap;      // F(k-1)^2, kept out here to reuse its limbs
+
+   for (--bit; bit >= 0; --bit)
+   {
+      // (F(k+1) - F(k))^2, which is F(k-1)^2
+      gap = b;
+      gap -= a;
+      gap.square();
+
+      a.square();
+      b.square();
+
+      // F(2k+1) = F(k)^2 + F(k+1)^2 goes into a, and
+      // F(2k) = F(k+1)^2 - F(k-1)^2 into b
+      a += b;
+      b -= gap;
+
+      // k becomes 2k + 1 or 2k depending on this bit
+      if ((n >> bit) & 1)
+         b += a;
+      else
+         swap(a, b);
+   }
+}
+
+/************************************************
+ * FIBONACCI SEQUENTIAL
+ * Finds the nth Fibonacci number the long way,
+ * by adding each number onto the one before it
+ ***********************************************/
+WholeNumber fibonacciSequential(uint64_t n)
+{
+   WholeNumber a(0);   // F(k)
+   WholeNumber b(1);   // F(k+1)
+
+   // F(k+2) = F(k) + F(k+1) overwrites F(k), then the
+   // two trade places; neither step copies any limbs
+   for (; n > 0; --n)
+   {
+      a += b;
+      swap(a, b);
+   }
+
+   return a;
+}
+
+/************************************************
+ * COST MODEL
+ * Rough costs, in limb operations, of the ways to
+ * get from one index to the next. Only how they
+ * compare matters, not how big they are.
+ ***********************************************/
+
+// limbs in F(n), which has about n log2(phi) bits
+static double limbsAt(uint64_t n)
+{
+   return (double)n * 0.6942419136306174 / 32.0 + 1.0;
+}
+
+// an a by b limb product, a >= b: schoolbook for small b, and b-sized
+// Karatsuba blocks after that
+static double productCost(double a, double b)
+{
+   if (b < 32.0)
+      return a * b;
+   return a / b * pow(b, 1.585) * 3.0;
+}
+
+// F(n) and F(n + 1) from scratch: three squares at every bit, which
+// together come to about one and a half times the last three
+static double pairCost(uint64_t n)
+{
+   double limbs = limbsAt(n);
+   return 4.5 * productCost(limbs, limbs);
+}
+
+// n additions on numbers the size of F(to)
+static double stepCost(uint64_t to, uint64_t gap)
+{
+   return (double)gap * limbsAt(to);
+}
+
+// three products with F(gap) sized numbers, after finding those
+static double jumpCost(uint64_t to, uint64_t gap)
+{
+   return pairCost(gap) + 3.0 * productCost(limbsAt(to), limbsAt(gap));
+}
+
+/************************************************
+ * JUMP
+ * Moves a = F(k), b = F(k+1) ahead by gap using
+ *    F(k+g)   = F(k) F(g-1) + F(k+1) F(g)
+ *    F(k+g+1) = F(k+2) F(g+1) - F(k) F(g-1)
+ * which is three products instead of four
+ ***********************************************/
+static void jump(WholeNumber & a, WholeNumber & b, uint64_t gap)
+{
+   assert(gap > 0);
+   WholeNumber before;   // F(g-1), then F(g+1)
+   WholeNumber at;       // F(g)
+   fibonacciPair(gap - 1, before, at);
+
+   WholeNumber sum = a + b;     // F(k+2)
+   a *= before;                  // F(k) F(g-1)
+   b *= at;                      // F(k+1) F(g)
+   before += at;                 // F(g+1)
+   sum *= before;
+   sum -= a;
+   a += b;
+   swap(b, sum);
+}
+
+/************************************************
+ * ADVANCE
+ * Moves a = F(from), b = F(from + 1) up to F(to)
+ * and F(to + 1) by whichever of stepping, jumping
+ * or starting over the cost model likes best.
+ * Given a cache, a checkpoint in it past from is
+ * a head start, and stepping leaves the ones it
+ * passes behind.
+ ***********************************************/
+static void advance(CheckpointCache * cache, uint64_t from, uint64_t to,
+                    WholeNumber & a, WholeNumber & b)
+{
+   assert(from <= to);
+   if (from == to)
+      return;
+
+   uint64_t k;
+   if (cache && cache->find(to, k, a, b, from + 1))
+      from = k;
+   uint64_t gap = to - from;
+   if (gap == 0)
+      return;
+
+   double step = stepCost(to, gap);
+   double leap = jumpCost(to, gap);
+   if (pairCost(to) < min(step, leap))
+      fibonacciPair(to, a, b);
+   else if (step <= leap)
+      for (k = from + 1; k <= to; k++)
+      {
+         a += b;
+         swap(a, b);
+         if (cache && k % cache->stride() == 0)
+            cache->store(k, a, b);
+      }
+   else
+      jump(a, b, gap);
+}
+
+/************************************************
+ * FIBONACCI ADVANCE
+ ***********************************************/
+void fibonacciAdvance(uint64_t from, uint64_t to, WholeNumber & a, WholeNumber & b)
+{
+   advance(NULL, from, to, a, b);
+}
+
+void fibonacciAdvance(CheckpointCache & cache, uint64_t from, uint64_t to,
+                      WholeNumber & a, WholeNumber & b)
+{
+   advance(&cache, from, to, a, b);
+}
+
+/************************************************
+ * SWEEP
+ * Runs one cluster of the plan: F(first) through
+ * the checkpoint cache, then on up to each index
+ * after it
+ ***********************************************/
+static void sweep(const vector <uint64_t> & indices, const vector <size_t> & order,
+                  size_t begin, size_t end, vector <WholeNumber> & results)
+{
+   WholeNumber a;
+   WholeNumber b;
+   uint64_t k = indices[order[begin]];
+   CheckpointCache & cache = CheckpointCache::shared();
+   cache.pair(k, a, b);
+
+   for (size_t i = begin; i < end; i++)
+   {
+      uint64_t target = indices[order[i]];
+      fibonacciAdvance(cache, k, target, a, b);
+      k = target;
+      results[order[i]] = a;
+   }
+}
+
+/************************************************
+ * FIBONACCI BATCH
+ * Plans the batch before computing anything. The
+ * indices are sorted, and each one either carries
+ * on from the one before it or, if getting there
+ * would cost more than starting fresh, begins a
+ * new cluster. Clustered indices pay little more
+ * than their largest member does. The clusters
+ * are separate tasks on the shared pool, largest
+ * first so that one big straggler does not run
+ * alone at the end.
+ ***********************************************/
+vector <WholeNumber> fibonacciBatch(const vector <uint64_t> & indices)
+{
+   vector <size_t> order(indices.size());
+   for (size_t i = 0; i < order.size(); i++)
+      order[i] = i;
+   sort(order.begin(), order.end(),
+        [&](size_t lhs, size_t rhs) { return indices[lhs] < indices[rhs]; });
+
+   // where each cluster starts, with the end of the last one
+   vector <size_t> starts;
+   for (size_t i = 0; i < order.size(); i++)
+   {
+      uint64_t target = indices[order[i]];
+      if (i > 0)
+      {
+         uint64_t gap = target - indices[order[i - 1]];
+         double carryOn = min(stepCost(target, gap), jumpCost(target, gap));
+         if (carryOn <= pairCost(target))
+            continue;
+      }
+      starts.push_back(i);
+   }
+   starts.push_back(order.size());
+
+   vector <WholeNumber> results(indices.size());
+   ThreadPool & pool = ThreadPool::shared();
+   TaskGroup group;
+   for (size_t c = starts.size() - 1; c-- > 0; )
+   {
+      size_t begin = starts[c];
+      size_t end = starts[c + 1];
+      pool.run(group, [&indices, &order, &results, begin, end]
+      {
+         sweep(indices, order, begin, end, results);
+      });
+   }
+   pool.wait(group);
+
+   return results;
+}
+
+/************************************************
+ * INDEX OF
+ * Constants for going from F(n) back to n, and
+ * the primes a candidate is checked against first
+ ***********************************************/
+
+// log2(sqrt(5)) and log2(phi), since F(n) is about phi^n / sqrt(5)
+#define LOG2_ROOT5 1.1609640474436813
+#define LOG2_PHI   0.6942419136306174
+
+#define INDEX_PRIMES 3
+static const Limb INDEX_PRIME[INDEX_PRIMES] =
+{
+   4294967291u, 4294967279u, 4294967231u
+};
+
+/************************************************
+ * FIBONACCI INDEX OF
+ * F(n) is phi^n / sqrt(5) to within a half, so n
+ * is log2(x sqrt(5)) / log2(phi), which the top
+ * limbs of x give closely enough to round. That
+ * leaves one candidate. x is compared with F(n)
+ * modulo a few primes, which throws out nearly
+ * every number that is not F(n) in one pass over
+ * its limbs, and only then is F(n) found to be sure.
+ ***********************************************/
+bool fibonacciIndexOf(const WholeNumber & x, uint64_t & n)
+{
+   const Limb * limbs = x.limbs();
+   size_t size = x.size();
+
+   // anything in 64 bits is looked up in the table
+   if (size <= 2)
+   {
+      uint64_t value = limbs[0];
+      if (size == 2)
+         value |= (uint64_t)limbs[1] << 32;
+      const uint64_t * begin = FIBONACCI_TABLE.values;
+      const uint64_t * end = begin + FIBONACCI_TABLE_SIZE;
+      const uint64_t * found = lower_bound(begin + 1, end, value);
+      if (value == 0)
+         found = begin;
+      if (found == end || *found != value)
+         return false;
+      n = (uint64_t)(found - begin);
+      return true;
+   }
+
+   double top = (double)limbs[size - 1] * 4294967296.0 + limbs[size - 2];
+   double bits = log2(top) + 32.0 * (double)(size - 2);
+   uint64_t candidate = (uint64_t)llround((bits + LOG2_ROOT5) / LOG2_PHI);
+
+   // x mod each prime, from the top limb down
+   uint64_t residues[INDEX_PRIMES] = { 0 };
+   for (size_t i = size; i-- > 0; )
+      for (int p = 0; p < INDEX_PRIMES; p++)
+         residues[p] = (residues[p] << 32 | limbs[i]) % INDEX_PRIME[p];
+   for (int p = 0; p < INDEX_PRIMES; p++)
+      if (fibonacciMod(candidate, INDEX_PRIME[p]) != residues[p])
+         return false;
+
+   if (fibonacciAt(candidate) != x)
+      return false;
+   n = candidate;
+   return true;
+}
 
 /************************************************
  * FIBONACCI
@@ -26,18 +406,16 @@ void fibonacci()
    cout << "How many Fibonacci numbers would you like to see? ";
    cin  >> number;
 
-   // Start with the initial number (1) and the initial predecessor
+   // Start with the initial number (1) and the one after it
    {
-      WholeNumber a(0);
-      WholeNumber b(0);
-      WholeNumber fib(1);
+      WholeNumber a(1);
+      WholeNumber b(1);
 
       while (number > 0)
       {
-         cout << '\t' << fib << endl;
-         a = b;
-         b = fib;
-         fib += a;
+         cout << '\t' << a << endl;
+         a += b;
+         swap(a, b);
 
          --number;
       }
@@ -47,20 +425,9 @@ void fibonacci()
    cout << "Which Fibonacci number would you like to display? ";
    cin  >> number;
 
-   // your code to display the <number>th Fibonacci number
-   {
-      WholeNumber a(0);
-      WholeNumber b(0);
-      WholeNumber fib(1);
-      while (number > 1)
-      {
-         a = b;
-         b = fib;
-         fib += a;
-         --number;
-      }
-      cout << '\t' << fib << endl;
-   }
+   // your code to display the <number>th Fibonacci number; as the
+   // loop this replaced did, anything below 1 shows F(1)
+   cout << '\t' << fibonacciAt(number > 0 ? number : 1) << endl;
 }
 
 
@@ -11,8 +11,69 @@
 #ifndef FIBONACCI_H
 #define FIBONACCI_H
 
+#include <cstdint>
+#include <vector>
+#include "wholeNumber.h"
+
+class CheckpointCache;
+
+// F(92) is the last Fibonacci number below 2^63, and F(93) the last
+// below 2^64
+#define FIBONACCI_TABLE_SIZE 94
+
+/************************************************
+ * FIBONACCI TABLE
+ * F(0) through F(93), worked out by the compiler
+ ***********************************************/
+struct FibonacciTable
+{
+   constexpr FibonacciTable() : values()
+   {
+      values[1] = 1;
+      for (int n = 2; n < FIBONACCI_TABLE_SIZE; n++)
+         values[n] = values[n - 1] + values[n - 2];
+   }
+
+   constexpr uint64_t operator [] (uint64_t n) const { return values[n]; }
+
+   uint64_t values[FIBONACCI_TABLE_SIZE];
+};
+
+constexpr FibonacciTable FIBONACCI_TABLE;
+static_assert(FIBONACCI_TABLE[93] == 12200160415121876738ULL,
+              "F(93) is the largest Fibonacci number in 64 bits");
+
 // the interactive fibonacci program
 void fibonacci();
 
-#endif // FIBONACCI_H
+// the nth Fibonacci number, F(0) = 0 and F(1) = 1, by fast doubling.
+// Up to F(93) comes straight from the table, and past that the shared
+// checkpoint cache gives a head start
+WholeNumber fibonacciAt(uint64_t n);
 
+// F(n) into current and F(n + 1) into next, for the same work as F(n)
+void fibonacciPair(uint64_t n, WholeNumber & current, WholeNumber & next);
+
+// moves current = F(from), next = F(from + 1) up to F(to) and F(to + 1),
+// stepping, jumping or starting over, whichever is cheapest
+void fibonacciAdvance(uint64_t from, uint64_t to,
+                      WholeNumber & current, WholeNumber & next);
+
+// the same, starting from a checkpoint in cache on the way if there is
+// one, and leaving the ones it steps through in cache
+void fibonacciAdvance(CheckpointCache & cache, uint64_t from, uint64_t to,
+                      WholeNumber & current, WholeNumber & next);
+
+// the same number found by adding our way up one step at a time.
+// This is far too slow for big n; it is kept as a reference for tests
+WholeNumber fibonacciSequential(uint64_t n);
+
+// is x a Fibonacci number, and if so, which? For 1, which is both F(1)
+// and F(2), n is 1
+bool fibonacciIndexOf(const WholeNumber & x, uint64_t & n);
+
+// F(n) for every n in indices, in the same order. Nearby indices share
+// the work, and the rest are found in parallel
+std::vector <WholeNumber> fibonacciBatch(const std::vector <uint64_t> & indices);
+
+#endif // FIBONACCI_H
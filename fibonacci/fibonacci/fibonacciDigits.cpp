@@ -0,0 +1,256 @@
+/***********************************************************************
+ * Implementation:
+ *    FIBONACCI DIGITS
+ * Summary:
+ *    Fixed-point numbers here are WholeNumbers counted in units of
+ *    2^-768, so the last FIXED_LIMBS limbs are the part after the
+ *    point. With n below 2^64, the logarithm comes out good to about
+ *    2^-700 and ten to its fraction to about 2^-690, so an answer is
+ *    trusted unless it is within 2^-256 of a whole number.
+ * Author
+ *    Matthew Burr, Shayla Nelson, Bryan Lopez, Kimberly Stowe
+ **********************************************************************/
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+#include <vector>
+#include "fibonacci.h"
+#include "fibonacciDigits.h"
+#include "fibonacciMod.h"
+#include "wholeNumber.h"
+using namespace std;
+
+// limbs after the point, 768 bits
+#define FIXED_LIMBS 24
+
+// the top limbs of a fraction that must not all be 0 or all be ones
+// for the whole part to be trusted
+#define GUARD_LIMBS 8
+
+// below this F(n) is found outright, which is about as quick
+#define EXACT_INDEX 4096
+
+// e^x is found as (e^(x / 2^EXP_HALVINGS))^(2^EXP_HALVINGS)
+#define EXP_HALVINGS 8
+
+// the constants to 768 bits, least significant limb first, with the
+// whole part in the last limb
+static const Limb LOG10_PHI[FIXED_LIMBS + 1] =
+{
+   0x1da0e530, 0xfb14b759, 0xa996f5ad, 0x7d44c8d9, 0xfb5c4320,
+   0xaadb5a53, 0xfb474b68, 0xcf053a50, 0x5d98729c, 0xfea8be88,
+   0xa3ea3cc4, 0xd6ea315f, 0x64b9626b, 0xa1361a71, 0x1b20e80e,
+   0x5a151af8, 0xa61d586d, 0xff8b851d, 0xe9bdd71c, 0x887a5e47,
+   0x845599f5, 0x65d3db23, 0x2451b7f3, 0x358036c8, 0x00000000
+};
+
+static const Limb LOG10_ROOT5[FIXED_LIMBS + 1] =
+{
+   0x3a9b4988, 0xc51bbb59, 0x0863bf42, 0x8b64f634, 0xcefe7f46,
+   0xd8c38b9b, 0x7f6aa8d0, 0xe81f2084, 0xb6ab4b4c, 0x69d2b602,
+   0x939d1b78, 0x5bae32da, 0x32e390bb, 0xd868d0e3, 0x9b98150b,
+   0x35e5749f, 0x520ce70d, 0x9d686436, 0xaf0b832d, 0xf654b3ce,
+   0xfd20dba1, 0xdc1da994, 0xc10c0219, 0x5977d95e, 0x00000000
+};
+
+static const Limb LN_10[FIXED_LIMBS + 1] =
+{
+   0x48671eef, 0x4586ed27, 0x2acf1be9, 0xbd9b3ac1, 0xc360c7ef,
+   0xd96a9b0e, 0x2a324479, 0xe0b3e28a, 0x0b945b59, 0xee3de210,
+   0x042f8b6b, 0xb1889061, 0xb17c35a0, 0x31c32f00, 0xc6a04173,
+   0x58bc0b5e, 0x07c0b5ca, 0x0f187a08, 0x6977e43a, 0x8a3fb3e7,
+   0x0b4c28a3, 0xa95b58ae, 0xaaa2b05b, 0x4d763776, 0x00000002
+};
+
+/************************************************
+ * FIXED POINT
+ ***********************************************/
+
+// one of the constants above
+static WholeNumber constant(const Limb * limbs)
+{
+   return WholeNumber(WholeNumberView(limbs, FIXED_LIMBS + 1));
+}
+
+// the whole part of x, which also brings a product of two fixed-point
+// numbers back to scale
+static WholeNumber wholePart(const WholeNumber & x)
+{
+   if (x.size() <= FIXED_LIMBS)
+      return WholeNumber(0);
+   return WholeNumber(WholeNumberView(x.limbs() + FIXED_LIMBS,
+                                      x.size() - FIXED_LIMBS));
+}
+
+// the part of x after the point
+static WholeNumber fractionPart(const WholeNumber & x)
+{
+   return WholeNumber(WholeNumberView(x.limbs(), min <size_t>(x.size(),
+                                                              FIXED_LIMBS)));
+}
+
+// is this fraction too near 0 or 1 to say which side it is on?
+static bool nearWhole(const WholeNumber & fraction)
+{
+   if (fraction.size() <= FIXED_LIMBS - GUARD_LIMBS)
+      return true;
+   if (fraction.size() < FIXED_LIMBS)
+      return false;
+
+   for (size_t i = FIXED_LIMBS - GUARD_LIMBS; i < FIXED_LIMBS; i++)
+      if (fraction.limbs()[i] != 0xffffffff)
+         return false;
+   return true;
+}
+
+/************************************************
+ * POWER OF TEN
+ * 10^f for a fraction f, as e^(f ln 10). The
+ * exponent is first halved EXP_HALVINGS times so
+ * the series converges quickly, then the sum is
+ * squared as many times.
+ ***********************************************/
+static WholeNumber powerOfTen(const WholeNumber & f)
+{
+   WholeNumber x = wholePart(f * constant(LN_10));
+   x.divideByLimb(1 << EXP_HALVINGS);
+
+   vector <Limb> oneLimbs(FIXED_LIMBS + 1, 0);
+   oneLimbs.back() = 1;
+   WholeNumber sum(WholeNumberView(&oneLimbs[0], oneLimbs.size()));
+
+   // x^k / k! until it drops below the last bit
+   WholeNumber term = sum;
+   for (Limb k = 1; !term.isZero(); k++)
+   {
+      term = wholePart(term * x);
+      term.divideByLimb(k);
+      sum += term;
+   }
+
+   for (int i = 0; i < EXP_HALVINGS; i++)
+   {
+      sum.square();
+      sum = wholePart(sum);
+   }
+   return sum;
+}
+
+/************************************************
+ * LOGARITHM
+ * log10 F(n), split into its whole part and the
+ * fraction after the point. False if the fraction
+ * is too near a whole number to trust. For n of
+ * EXACT_INDEX or more, the psi^n in Binet's formula
+ * is far below the last bit.
+ ***********************************************/
+static bool logarithm(uint64_t n, uint64_t & whole, WholeNumber & fraction)
+{
+   assert(n >= EXACT_INDEX);
+   WholeNumber y = constant(LOG10_PHI) * WholeNumber(n);
+   y -= constant(LOG10_ROOT5);
+
+   WholeNumber top = wholePart(y);
+   whole = top.limbs()[0];
+   if (top.size() > 1)
+      whole |= (uint64_t)top.limbs()[1] << 32;
+
+   fraction = fractionPart(y);
+   return !nearWhole(fraction);
+}
+
+/************************************************
+ * EXACT DIGITS
+ * All of F(n), when it is small enough to find or
+ * the shortcut cannot be trusted
+ ***********************************************/
+static string exactDigits(uint64_t n)
+{
+   string text;
+   fibonacciAt(n).toString(text, DIGITS_PLAIN);
+   return text;
+}
+
+/************************************************
+ * FIBONACCI DIGIT COUNT
+ ***********************************************/
+uint64_t fibonacciDigitCount(uint64_t n)
+{
+   uint64_t whole;
+   WholeNumber fraction;
+   if (n < EXACT_INDEX || !logarithm(n, whole, fraction))
+      return exactDigits(n).size();
+
+   return whole + 1;
+}
+
+/************************************************
+ * FIBONACCI LEADING DIGITS
+ * F(n) = 10^(whole + fraction), so its first count
+ * digits are the whole part of 10^(fraction + count - 1)
+ ***********************************************/
+string fibonacciLeadingDigits(uint64_t n, unsigned count) throw (const char *)
+{
+   if (count == 0 || count > LEADING_DIGITS_MOST)
+      throw "ERROR: leading digits must number from 1 to 100";
+
+   uint64_t whole;
+   WholeNumber fraction;
+   if (n < EXACT_INDEX || !logarithm(n, whole, fraction))
+      return exactDigits(n).substr(0, count);
+
+   WholeNumber value = powerOfTen(fraction);
+   for (unsigned i = 1; i < count; i++)
+      value.multiplyByLimb(10);
+   if (nearWhole(fractionPart(value)))
+      return exactDigits(n).substr(0, count);
+
+   string text;
+   wholePart(value).toString(text, DIGITS_PLAIN);
+   assert(text.size() == count);
+   return text;
+}
+
+/************************************************
+ * FIBONACCI TRAILING DIGITS
+ * 10^count does not fit in 64 bits for more than
+ * 19 digits, so F(n) is found mod 2^count and mod
+ * 5^count, and the two joined by the Chinese
+ * remainder theorem:
+ *    x = r5 + 5^count ((r2 - r5) / 5^count mod 2^count)
+ ***********************************************/
+string fibonacciTrailingDigits(uint64_t n, unsigned count) throw (const char *)
+{
+   if (count == 0 || count > TRAILING_DIGITS_MOST)
+      throw "ERROR: trailing digits must number from 1 to 27";
+
+   if (n < EXACT_INDEX)
+   {
+      string text = exactDigits(n);
+      return text.size() <= count ? text : text.substr(text.size() - count);
+   }
+
+   uint64_t twos = (uint64_t)1 << count;
+   uint64_t fives = 1;
+   for (unsigned i = 0; i < count; i++)
+      fives *= 5;
+
+   uint64_t r2 = fibonacciMod(n, twos);
+   uint64_t r5 = fibonacciMod(n, fives);
+
+   // 1 / 5^count mod 2^64 by Newton's method, each step doubling the
+   // bits that are right, from the three that 5^count already has
+   uint64_t inverse = fives;
+   for (int i = 0; i < 5; i++)
+      inverse *= 2 - fives * inverse;
+   uint64_t t = (r2 - r5) * inverse & (twos - 1);
+
+   WholeNumber value = WholeNumber(fives) * WholeNumber(t);
+   value += WholeNumber(r5);
+
+   // F(n) has far more than count digits, so the zeros in front count
+   string text;
+   value.toString(text, DIGITS_PLAIN);
+   return string(count - text.size(), '0') + text;
+}
@@ -0,0 +1,37 @@
+/***********************************************************************
+ * Header:
+ *    FIBONACCI DIGITS
+ * Summary:
+ *    How many digits F(n) has, and what its first and last few are,
+ *    without building F(n). The front comes from Binet's formula,
+ *       log10 F(n) = n log10(phi) - log10(sqrt(5)),
+ *    worked out in fixed point with far more bits than the answer
+ *    needs. When the answer falls too close to a power of ten to be
+ *    sure of, F(n) is found exactly instead. The back is F(n) mod 10^k.
+ * Author
+ *    Matthew Burr, Shayla Nelson, Bryan Lopez, Kimberly Stowe
+ ************************************************************************/
+
+#ifndef FIBONACCIDIGITS_H
+#define FIBONACCIDIGITS_H
+
+#include <cstdint>
+#include <string>
+
+// the most digits that can be asked for from either end
+#define LEADING_DIGITS_MOST  100
+#define TRAILING_DIGITS_MOST 27
+
+// how many decimal digits F(n) has
+uint64_t fibonacciDigitCount(uint64_t n);
+
+// the first count digits of F(n), or all of them if it has fewer
+std::string fibonacciLeadingDigits(uint64_t n, unsigned count)
+   throw (const char *);
+
+// the last count digits of F(n), zeros and all, or all of them if it
+// has fewer
+std::string fibonacciTrailingDigits(uint64_t n, unsigned count)
+   throw (const char *);
+
+#endif // FIBONACCIDIGITS_H
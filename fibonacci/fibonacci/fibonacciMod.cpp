@@ -0,0 +1,408 @@
+/***********************************************************************
+ * Implementation:
+ *    FIBONACCI MOD
+ * Summary:
+ *    Doubling on remainders, the Pisano period, and the batch. Every
+ *    modulus m is split into 2^s times an odd part; the odd part is
+ *    worked in Montgomery form and the 2^s part in wrapping arithmetic,
+ *    so there is no division anywhere in the doubling loop.
+ * Author
+ *    Matthew Burr, Shayla Nelson, Bryan Lopez, Kimberly Stowe
+ **********************************************************************/
+
+#include <algorithm>
+#include <cassert>
+#include "fibonacciMod.h"
+using namespace std;
+
+// trial division looks for factors of m up to here
+#define PISANO_TRIAL 65536
+
+// below this many bits, walking the bits of n is cheaper than
+// factoring m to find its Pisano period
+#define PISANO_BITS 32768
+
+// how many (n, m) pairs the batch works on side by side
+#define MOD_LANES 8
+
+/************************************************
+ * MONTGOMERY MULTIPLY
+ * a b R^-1 mod p for a, b < p, with R = 2^64 and
+ * inverse = p^-1 mod 2^64. Subtracting the high
+ * half instead of adding it lets p use all 64 bits.
+ ***********************************************/
+static inline uint64_t montgomeryMultiply(uint64_t a, uint64_t b, uint64_t p,
+                                          uint64_t inverse)
+{
+   unsigned __int128 t = (unsigned __int128)a * b;
+   uint64_t high = (uint64_t)(t >> 64);
+   uint64_t q = (uint64_t)t * inverse;
+   uint64_t correction = (uint64_t)(((unsigned __int128)q * p) >> 64);
+   uint64_t u = high - correction;
+   return high < correction ? u + p : u;
+}
+
+// a + b and a - b mod p, for a, b < p, without overflowing
+static inline uint64_t addMod(uint64_t a, uint64_t b, uint64_t p)
+{
+   uint64_t sum = a + b;
+   return (sum < a || sum >= p) ? sum - p : sum;
+}
+
+static inline uint64_t subtractMod(uint64_t a, uint64_t b, uint64_t p)
+{
+   return a >= b ? a - b : a - b + p;
+}
+
+/************************************************
+ * MODULUS
+ * m = 2^s odd, with what Montgomery form needs to
+ * work modulo odd
+ ***********************************************/
+struct Modulus
+{
+   uint64_t odd;       // m without its factors of two
+   uint64_t inverse;   // odd^-1 mod 2^64
+   uint64_t one;       // R mod odd, which is 1 in Montgomery form
+   uint64_t r2;        // R^2 mod odd
+   uint64_t mask;      // 2^s - 1
+
+   Modulus(uint64_t m) throw (const char *)
+   {
+      if (m == 0)
+         throw "ERROR: a Fibonacci number cannot be taken mod 0";
+
+      mask = 0;
+      for (odd = m; odd % 2 == 0; odd /= 2)
+         mask = (mask << 1) | 1;
+
+      // Newton's method doubles the correct bits of odd^-1 every step
+      inverse = odd;
+      for (int i = 0; i < 6; i++)
+         inverse *= 2 - odd * inverse;
+
+      unsigned __int128 r = ((unsigned __int128)1 << 64) % odd;
+      one = (uint64_t)r;
+      r2 = (uint64_t)(r * r % odd);
+   }
+
+   uint64_t multiply(uint64_t a, uint64_t b) const
+   {
+      return montgomeryMultiply(a, b, odd, inverse);
+   }
+
+   uint64_t toForm(uint64_t a) const   { return multiply(a % odd, r2); }
+   uint64_t fromForm(uint64_t a) const { return multiply(a, 1);         }
+
+   // x mod m from x mod odd and x mod 2^s, by the Chinese remainder
+   // theorem: x = oddPart + odd ((twoPart - oddPart) odd^-1 mod 2^s)
+   uint64_t join(uint64_t oddPart, uint64_t twoPart) const
+   {
+      return oddPart + odd * (((twoPart - oddPart) * inverse) & mask);
+   }
+};
+
+/************************************************
+ * MOD PAIR
+ * F(k) and F(k+1), both mod the odd part (in
+ * Montgomery form) and mod 2^64
+ ***********************************************/
+struct ModPair
+{
+   ModPair(const Modulus & mod) : a(0), b(mod.one), a2(0), b2(1) { }
+
+   uint64_t a;
+   uint64_t b;
+   uint64_t a2;
+   uint64_t b2;
+};
+
+/************************************************
+ * DOUBLE STEP
+ * k becomes 2k + bit, using
+ *    F(2k)   = F(k) (2 F(k+1) - F(k))
+ *    F(2k+1) = F(k)^2 + F(k+1)^2
+ * Both choices are worked out and one is kept, so
+ * there is no branch on the bit.
+ ***********************************************/
+static inline void doubleStep(uint64_t p, uint64_t inverse, uint64_t & a,
+                              uint64_t & b, uint64_t & a2, uint64_t & b2,
+                              uint64_t bit)
+{
+   uint64_t take = 0 - bit;
+
+   uint64_t even = montgomeryMultiply(a, subtractMod(addMod(b, b, p), a, p),
+                                      p, inverse);
+   uint64_t odd = addMod(montgomeryMultiply(a, a, p, inverse),
+                         montgomeryMultiply(b, b, p, inverse), p);
+   uint64_t after = addMod(even, odd, p);
+   a = even ^ ((even ^ odd) & take);
+   b = odd ^ ((odd ^ after) & take);
+
+   uint64_t even2 = a2 * (2 * b2 - a2);
+   uint64_t odd2 = a2 * a2 + b2 * b2;
+   a2 = even2 ^ ((even2 ^ odd2) & take);
+   b2 = odd2 ^ ((odd2 ^ (even2 + odd2)) & take);
+}
+
+static inline void doubleStep(const Modulus & mod, ModPair & pair, uint64_t bit)
+{
+   doubleStep(mod.odd, mod.inverse, pair.a, pair.b, pair.a2, pair.b2, bit);
+}
+
+static inline uint64_t finish(const Modulus & mod, const ModPair & pair)
+{
+   return mod.join(mod.fromForm(pair.a), pair.a2);
+}
+
+/************************************************
+ * FIBONACCI MOD
+ * For a 64-bit n this is at most 64 steps, which
+ * is less than factoring m would cost, so there is
+ * no Pisano reduction here.
+ ***********************************************/
+uint64_t fibonacciMod(uint64_t n, uint64_t m) throw (const char *)
+{
+   Modulus mod(m);
+   ModPair pair(mod);
+
+   for (int bit = 63; bit >= 0; --bit)
+      if (n >> bit)
+         doubleStep(mod, pair, (n >> bit) & 1);
+
+   return finish(mod, pair);
+}
+
+/************************************************
+ * FIBONACCI MOD : WHOLE NUMBER
+ * A long n is cut down to n mod a multiple of the
+ * Pisano period, which leaves the same remainder
+ * since F(n) mod m repeats with that period. If no
+ * period can be found we walk every bit of n.
+ ***********************************************/
+uint64_t fibonacciMod(const WholeNumber & n, uint64_t m) throw (const char *)
+{
+   Modulus mod(m);
+   const Limb * limbs = n.limbs();
+   size_t size = n.size();
+
+   if (size * 32 <= 64)
+   {
+      uint64_t small = 0;
+      for (size_t i = size; i-- > 0; )
+         small = (small << 32) | limbs[i];
+      return fibonacciMod(small, m);
+   }
+
+   uint64_t period = size * 32 > PISANO_BITS ? pisanoMultiple(m) : 0;
+   if (period)
+   {
+      uint64_t reduced = 0;
+      for (size_t i = size; i-- > 0; )
+         reduced = (uint64_t)((((unsigned __int128)reduced << 32) | limbs[i])
+                              % period);
+      return fibonacciMod(reduced, m);
+   }
+
+   ModPair pair(mod);
+   for (size_t i = size; i-- > 0; )
+      for (int bit = 31; bit >= 0; --bit)
+         doubleStep(mod, pair, (limbs[i] >> bit) & 1);
+
+   return finish(mod, pair);
+}
+
+/************************************************
+ * IS PRIME
+ * Miller-Rabin with the first twelve primes as
+ * bases, which has no false positives below 2^64
+ ***********************************************/
+static bool isPrime(uint64_t n)
+{
+   static const uint64_t BASES[] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37 };
+
+   if (n < 2)
+      return false;
+   for (size_t i = 0; i < sizeof(BASES) / sizeof(BASES[0]); i++)
+      if (n % BASES[i] == 0)
+         return n == BASES[i];
+
+   // n - 1 = d 2^r
+   uint64_t d = n - 1;
+   int r = 0;
+   for (; d % 2 == 0; d /= 2)
+      r++;
+
+   Modulus mod(n);
+   uint64_t minusOne = n - mod.one;
+   for (size_t i = 0; i < sizeof(BASES) / sizeof(BASES[0]); i++)
+   {
+      uint64_t x = mod.one;
+      uint64_t base = mod.toForm(BASES[i]);
+      for (uint64_t e = d; e; e >>= 1)
+      {
+         if (e & 1)
+            x = mod.multiply(x, base);
+         base = mod.multiply(base, base);
+      }
+
+      bool passed = x == mod.one || x == minusOne;
+      for (int j = 1; j < r && !passed; j++)
+      {
+         x = mod.multiply(x, x);
+         passed = x == minusOne;
+      }
+      if (!passed)
+         return false;
+   }
+   return true;
+}
+
+/************************************************
+ * PRIME CYCLE
+ * A multiple of the Pisano period of a prime p:
+ * 3 for 2, 20 for 5, p - 1 when p is 1 or 4 mod 5,
+ * and 2 (p + 1) otherwise
+ ***********************************************/
+static unsigned __int128 primeCycle(uint64_t p)
+{
+   if (p == 2)
+      return 3;
+   if (p == 5)
+      return 20;
+   if (p % 5 == 1 || p % 5 == 4)
+      return p - 1;
+   return ((unsigned __int128)p + 1) * 2;
+}
+
+/************************************************
+ * LCM INTO
+ * multiple = lcm(multiple, term), false if that
+ * does not fit in 64 bits
+ ***********************************************/
+static bool lcmInto(uint64_t & multiple, unsigned __int128 term)
+{
+   if (term > UINT64_MAX)
+      return false;
+
+   uint64_t x = multiple;
+   uint64_t y = (uint64_t)term;
+   while (y)
+   {
+      uint64_t t = x % y;
+      x = y;
+      y = t;
+   }
+
+   unsigned __int128 lcm = (unsigned __int128)(multiple / x) * (uint64_t)term;
+   if (lcm > UINT64_MAX)
+      return false;
+   multiple = (uint64_t)lcm;
+   return true;
+}
+
+/************************************************
+ * PISANO MULTIPLE
+ * The period of p^e divides p^(e-1) times the
+ * period of p, and the period of m is the lcm of
+ * those over its prime powers. Factors up to
+ * PISANO_TRIAL are found by trial division; what
+ * is left must then be 1 or a prime.
+ ***********************************************/
+uint64_t pisanoMultiple(uint64_t m)
+{
+   if (m == 0)
+      return 0;
+
+   uint64_t multiple = 1;
+   uint64_t rest = m;
+   for (uint64_t p = 2; p <= PISANO_TRIAL && p * p <= rest; p += (p == 2 ? 1 : 2))
+   {
+      if (rest % p)
+         continue;
+
+      uint64_t power = 1;   // p^(e-1)
+      for (rest /= p; rest % p == 0; rest /= p)
+         power *= p;
+      if (!lcmInto(multiple, primeCycle(p) * power))
+         return 0;
+   }
+
+   if (rest > 1 && (!isPrime(rest) || !lcmInto(multiple, primeCycle(rest))))
+      return 0;
+   return multiple;
+}
+
+/************************************************
+ * FIBONACCI MOD BATCH
+ * The pairs are sorted by n and taken MOD_LANES
+ * at a time, with each lane's state in its own
+ * array. The lanes share a loop over the bits, so
+ * their products are independent of each other
+ * and the processor can overlap them. Sorting
+ * means the lanes in a block need about as many
+ * steps as each other; a lane with a shorter n
+ * just doubles F(0) until its top bit comes.
+ ***********************************************/
+vector <uint64_t> fibonacciModBatch(const vector <uint64_t> & indices,
+                                    const vector <uint64_t> & moduli)
+   throw (const char *)
+{
+   if (indices.size() != moduli.size())
+      throw "ERROR: a batch needs one modulus for each index";
+
+   vector <size_t> order(indices.size());
+   for (size_t i = 0; i < order.size(); i++)
+      order[i] = i;
+   sort(order.begin(), order.end(),
+        [&](size_t lhs, size_t rhs) { return indices[lhs] < indices[rhs]; });
+
+   vector <uint64_t> results(indices.size());
+   for (size_t start = 0; start < order.size(); start += MOD_LANES)
+   {
+      size_t count = min((size_t)MOD_LANES, order.size() - start);
+
+      uint64_t n[MOD_LANES];
+      uint64_t p[MOD_LANES];
+      uint64_t inverse[MOD_LANES];
+      uint64_t mask[MOD_LANES];
+      uint64_t a[MOD_LANES];
+      uint64_t b[MOD_LANES];
+      uint64_t a2[MOD_LANES];
+      uint64_t b2[MOD_LANES];
+      uint64_t highest = 0;
+
+      // unused lanes work out F(0) mod 1
+      for (size_t j = 0; j < MOD_LANES; j++)
+      {
+         Modulus mod(j < count ? moduli[order[start + j]] : 1);
+         n[j] = j < count ? indices[order[start + j]] : 0;
+         p[j] = mod.odd;
+         inverse[j] = mod.inverse;
+         mask[j] = mod.mask;
+         a[j] = 0;
+         b[j] = mod.one;
+         a2[j] = 0;
+         b2[j] = 1;
+         highest |= n[j];
+      }
+
+      int top = 63;
+      while (top >= 0 && !((highest >> top) & 1))
+         --top;
+      for (int bit = top; bit >= 0; --bit)
+         for (size_t j = 0; j < MOD_LANES; j++)
+            doubleStep(p[j], inverse[j], a[j], b[j], a2[j], b2[j],
+                       (n[j] >> bit) & 1);
+
+      // the same join as Modulus::join
+      for (size_t j = 0; j < count; j++)
+      {
+         uint64_t oddPart = montgomeryMultiply(a[j], 1, p[j], inverse[j]);
+         results[order[start + j]] =
+            oddPart + p[j] * (((a2[j] - oddPart) * inverse[j]) & mask[j]);
+      }
+   }
+
+   return results;
+}
@@ -0,0 +1,39 @@
+/***********************************************************************
+ * Header:
+ *    FIBONACCI MOD
+ * Summary:
+ *    F(n) mod m without ever building F(n). Fast doubling works just
+ *    as well on remainders, so each bit of n costs three products of
+ *    64-bit numbers instead of three products of huge ones. An odd m
+ *    is handled in Montgomery form, a power of two by letting 64-bit
+ *    arithmetic wrap, and any other m by doing both and joining the
+ *    two answers with the Chinese remainder theorem.
+ * Author
+ *    Matthew Burr, Shayla Nelson, Bryan Lopez, Kimberly Stowe
+ ************************************************************************/
+
+#ifndef FIBONACCIMOD_H
+#define FIBONACCIMOD_H
+
+#include <cstdint>
+#include <vector>
+#include "wholeNumber.h"
+
+// F(n) mod m, for any m > 0
+uint64_t fibonacciMod(uint64_t n, uint64_t m) throw (const char *);
+
+// the same for an index of any size. n is first cut down by the
+// Pisano period of m when that is cheap to find
+uint64_t fibonacciMod(const WholeNumber & n, uint64_t m) throw (const char *);
+
+// a multiple of the Pisano period of m, the length of the cycle that
+// F(n) mod m repeats in. Zero when m cannot be factored quickly or the
+// multiple does not fit in 64 bits
+uint64_t pisanoMultiple(uint64_t m);
+
+// F(indices[i]) mod moduli[i] for every i, several at a time
+std::vector <uint64_t> fibonacciModBatch(const std::vector <uint64_t> & indices,
+                                         const std::vector <uint64_t> & moduli)
+   throw (const char *);
+
+#endif // FIBONACCIMOD_H
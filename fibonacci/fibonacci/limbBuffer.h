@@ -0,0 +1,241 @@
+/***********************************************************************
+* Header:
+*    LimbBuffer
+* Summary:
+*    A growable array of limbs for WholeNumber. The limbs sit next to
+*    each other in memory, least significant first, so the carry loops
+*    run straight down the array instead of chasing node pointers. The
+*    first few limbs live inside the buffer itself, so small numbers
+*    never touch the heap.
+* Author:
+*     Matthew Burr, Shayla Nelson, Bryan Lopez & Kimberly Stowe
+************************************************************************/
+
+#ifndef LIMBBUFFER_H
+#define LIMBBUFFER_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+// limbs kept inside the buffer before it needs a block of its own;
+// four 32-bit limbs hold any 128-bit number
+#define INLINE_LIMBS 4
+
+/************************************************
+ * LIMB BUFFER
+ * A contiguous, growable array of plain numbers.
+ * Capacity grows by doubling, and shrinking never
+ * gives memory back, so a number that is reused
+ * stops allocating once it is big enough. Up to
+ * INLINE_LIMBS of them are kept in place.
+ ***********************************************/
+template <class T>
+class LimbBuffer
+{
+public:
+   // default constructor
+   LimbBuffer() : data(inlineLimbs), numLimbs(0), numCapacity(INLINE_LIMBS)
+   {
+   }
+
+   // copy constructor
+   LimbBuffer(const LimbBuffer <T> & source) throw (const char *);
+
+   // move constructor: takes the limbs, leaving source empty. Limbs
+   // kept in place are copied, since they cannot be taken
+   LimbBuffer(LimbBuffer <T> && source) throw ()
+      : data(inlineLimbs), numLimbs(source.numLimbs),
+        numCapacity(INLINE_LIMBS)
+   {
+      if (source.isInline())
+         std::memcpy(inlineLimbs, source.inlineLimbs, numLimbs * sizeof(T));
+      else
+      {
+         data = source.data;
+         numCapacity = source.numCapacity;
+         source.data = source.inlineLimbs;
+         source.numCapacity = INLINE_LIMBS;
+      }
+      source.numLimbs = 0;
+   }
+
+   // destructor
+   ~LimbBuffer()
+   {
+      if (!isInline())
+         delete [] data;
+   }
+
+   // assignment operator
+   LimbBuffer <T> & operator = (const LimbBuffer <T> & rhs)
+      throw (const char *);
+
+   // move assignment: trades blocks with rhs, which frees ours later
+   LimbBuffer <T> & operator = (LimbBuffer <T> && rhs) throw ()
+   {
+      swap(rhs);
+      return *this;
+   }
+
+   // additional methods
+   bool   empty()    const { return numLimbs == 0; }
+   size_t size()     const { return numLimbs;      }
+   size_t capacity() const { return numCapacity;   }
+
+   // makes room for at least this many limbs
+   void reserve(size_t newCapacity) throw (const char *);
+
+   // grows or shrinks to this many limbs, filling new ones with zero
+   void resize(size_t newSize) throw (const char *);
+
+   // adds a limb to the most significant end
+   void push_back(const T & limb) throw (const char *)
+   {
+      if (numLimbs == numCapacity)
+         reserve(numCapacity ? numCapacity * 2 : 4);
+      data[numLimbs++] = limb;
+   }
+
+   // removes the most significant limb
+   void pop_back()
+   {
+      assert(numLimbs > 0);
+      numLimbs--;
+   }
+
+   // drops every limb, keeping the memory
+   void clear() { numLimbs = 0; }
+
+   // exchanges the contents of two buffers without copying
+   void swap(LimbBuffer <T> & rhs) throw ();
+
+   // access to the limbs, least significant first
+   T &       operator [] (size_t index)       { return data[index]; }
+   const T & operator [] (size_t index) const { return data[index]; }
+   T *       limbs()       { return data; }
+   const T * limbs() const { return data; }
+
+   // the most significant limb
+   T &       back()       { assert(numLimbs > 0); return data[numLimbs - 1]; }
+   const T & back() const { assert(numLimbs > 0); return data[numLimbs - 1]; }
+
+private:
+   // are the limbs in place, rather than in a block of their own?
+   bool isInline() const { return data == inlineLimbs; }
+
+   T * data;                   // inlineLimbs or a block from new
+   size_t numLimbs;
+   size_t numCapacity;
+   T inlineLimbs[INLINE_LIMBS];
+};
+
+/*******************************************
+ * LIMB BUFFER :: COPY CONSTRUCTOR
+ *******************************************/
+template <class T>
+LimbBuffer <T> :: LimbBuffer(const LimbBuffer <T> & source)
+   throw (const char *) : data(inlineLimbs), numLimbs(0),
+                          numCapacity(INLINE_LIMBS)
+{
+   *this = source;
+}
+
+/*******************************************
+ * LIMB BUFFER :: ASSIGNMENT OPERATOR
+ * Only allocates when the limbs will not fit
+ * in what we already have
+ *******************************************/
+template <class T>
+LimbBuffer <T> & LimbBuffer <T> :: operator = (const LimbBuffer <T> & rhs)
+   throw (const char *)
+{
+   if (this == &rhs)
+      return *this;
+
+   numLimbs = 0;
+   reserve(rhs.numLimbs);
+   if (rhs.numLimbs)
+      std::memcpy(data, rhs.data, rhs.numLimbs * sizeof(T));
+   numLimbs = rhs.numLimbs;
+
+   return *this;
+}
+
+/*******************************************
+ * LIMB BUFFER :: RESERVE
+ * Moves the limbs into a larger block if the
+ * current one is too small
+ *******************************************/
+template <class T>
+void LimbBuffer <T> :: reserve(size_t newCapacity) throw (const char *)
+{
+   if (newCapacity <= numCapacity)
+      return;
+
+   T * newData;
+   try
+   {
+      newData = new T[newCapacity];
+   }
+   catch (std::bad_alloc)
+   {
+      throw "ERROR: unable to allocate limbs for a whole number";
+   }
+
+   if (numLimbs)
+      std::memcpy(newData, data, numLimbs * sizeof(T));
+   if (!isInline())
+      delete [] data;
+
+   data = newData;
+   numCapacity = newCapacity;
+}
+
+/*******************************************
+ * LIMB BUFFER :: RESIZE
+ *******************************************/
+template <class T>
+void LimbBuffer <T> :: resize(size_t newSize) throw (const char *)
+{
+   if (newSize > numCapacity)
+      reserve(newSize > numCapacity * 2 ? newSize : numCapacity * 2);
+
+   for (size_t i = numLimbs; i < newSize; i++)
+      data[i] = T();
+   numLimbs = newSize;
+}
+
+/*******************************************
+ * LIMB BUFFER :: SWAP
+ * Blocks trade owners, and the limbs kept in
+ * place trade places, which is a few words
+ *******************************************/
+template <class T>
+void LimbBuffer <T> :: swap(LimbBuffer <T> & rhs) throw ()
+{
+   if (this == &rhs)
+      return;
+
+   T * block = isInline() ? NULL : data;
+   T * rhsBlock = rhs.isInline() ? NULL : rhs.data;
+
+   T tempLimbs[INLINE_LIMBS];
+   std::memcpy(tempLimbs, inlineLimbs, sizeof(tempLimbs));
+   std::memcpy(inlineLimbs, rhs.inlineLimbs, sizeof(tempLimbs));
+   std::memcpy(rhs.inlineLimbs, tempLimbs, sizeof(tempLimbs));
+
+   data = rhsBlock ? rhsBlock : inlineLimbs;
+   rhs.data = block ? block : rhs.inlineLimbs;
+
+   size_t temp = numLimbs;
+   numLimbs = rhs.numLimbs;
+   rhs.numLimbs = temp;
+
+   temp = numCapacity;
+   numCapacity = rhs.numCapacity;
+   rhs.numCapacity = temp;
+}
+
+#endif // LIMBBUFFER_H
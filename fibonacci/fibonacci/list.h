@@ -17,26 +17,42 @@
 #include <cassert>
 #include <new>
 #include "listIterator.h"
+#include "nodePool.h"
 
 /************************************************
  * LIST
  * A class encapsulating the notion of a list.
+ * The nodes come from Alloc, which is a NodePool
+ * unless NodeAllocator (plain new/delete) is given.
  ***********************************************/
-template <class T>
+template <class T, class Alloc = NodePool <T> >
 class List
 {
 public:
    // default constructor
-   List <T>()  throw (const char*);
+   List <T, Alloc>()  throw (const char*);
 
    // copy constructor
-   List <T> (List<T> & source) throw (const char *);
+   List <T, Alloc> (List <T, Alloc> & source) throw (const char *);
+
+   // move constructor: takes the nodes, leaving source empty
+   List <T, Alloc> (List <T, Alloc> && source) throw (const char *);
 
    // destructor
    ~List();
 
    // assignment operator
-   List <T> & operator = (const List<T> & source);
+   List <T, Alloc> & operator = (const List <T, Alloc> & source);
+
+   // move assignment: trades nodes with source
+   List <T, Alloc> & operator = (List <T, Alloc> && source) throw ()
+   {
+      swap(source);
+      return *this;
+   }
+
+   // exchanges the contents of two lists without copying
+   void swap(List <T, Alloc> & rhs) throw ();
 
    // additional methods
    bool empty() const { return numElements == 0; }
@@ -75,6 +91,9 @@ public:
    //returns an iterator to past the front element in the list
    ListIterator <T> rend() const;
 
+   // where the nodes come from, for a look at its counters
+   const Alloc & allocator() const { return alloc; }
+
 private:
    // checks structure
    bool isValid() const;
@@ -82,12 +101,13 @@ private:
    // member variables
    Node <T> * m_node;
    int numElements;
+   Alloc alloc;
 };
 /*******************************************
 * LIST :: DEFAULT CONSTRUCTOR
 *******************************************/
-template <class T>
-List <T> ::List() throw (const char*)
+template <class T, class Alloc>
+List <T, Alloc> ::List() throw (const char*)
    : numElements(0), m_node(NULL)
 {
    try
@@ -105,8 +125,8 @@ List <T> ::List() throw (const char*)
 /*******************************************
  * LIST :: COPY CONSTRUCTOR
  *******************************************/
-template <class T>
-List <T> :: List(List <T> & source) throw (const char *)
+template <class T, class Alloc>
+List <T, Alloc> :: List(List <T, Alloc> & source) throw (const char *)
     : numElements(0), m_node(NULL)
 {
    // attempt to allocate
@@ -129,11 +149,53 @@ List <T> :: List(List <T> & source) throw (const char *)
    }
 }
 
+/*******************************************
+ * LIST :: MOVE CONSTRUCTOR
+ * The source keeps a fresh, empty sentinel so
+ * that it is still a valid list
+ *******************************************/
+template <class T, class Alloc>
+List <T, Alloc> :: List(List <T, Alloc> && source) throw (const char *)
+    : numElements(0), m_node(NULL)
+{
+   try
+   {
+      m_node = new Node <T>(T());
+      m_node->pNext = m_node;
+      m_node->pPrev = m_node;
+   }
+   catch (std::bad_alloc)
+   {
+      throw "ERROR: unable to allocate a new node for a list";
+   }
+
+   swap(source);
+}
+
+/*******************************************
+ * LIST :: SWAP
+ * The sentinels change hands, so every node
+ * stays where it is
+ *******************************************/
+template <class T, class Alloc>
+void List <T, Alloc> :: swap(List <T, Alloc> & rhs) throw ()
+{
+   Node <T> * tempNode = m_node;
+   m_node = rhs.m_node;
+   rhs.m_node = tempNode;
+
+   int tempElements = numElements;
+   numElements = rhs.numElements;
+   rhs.numElements = tempElements;
+
+   alloc.swap(rhs.alloc);
+}
+
 /*******************************************
  * LIST :: ASSIGNMENT OPERATOR
  *******************************************/
-template <class T>
-List <T> & List <T> :: operator = (const List<T> & source)
+template <class T, class Alloc>
+List <T, Alloc> & List <T, Alloc> :: operator = (const List <T, Alloc> & source)
 {
    clear();
    numElements = 0;
@@ -151,27 +213,30 @@ List <T> & List <T> :: operator = (const List<T> & source)
 /*******************************************
  * LIST :: DESTRUCTOR
  *******************************************/
-template <class T>
-List <T> :: ~List()
+template <class T, class Alloc>
+List <T, Alloc> :: ~List()
 {
    clear();
+   delete m_node;
 }
 
 /*****************************************************************************
 * LIST :: CLEAR
 * Empty the LIST of all its contents
 *****************************************************************************/
-template<class T>
-void List<T> :: clear()
+template <class T, class Alloc>
+void List <T, Alloc> :: clear()
 {
    // if we're already empty, then we don't need to do anything
    if (empty())
       return;
 
-   // iterate through the list, using remove() to clear the elements
-   for (ListIterator<T> it = begin();
-      it != end();)
-      remove(it);
+   // hand the whole chain back at once; a pool frees its slabs
+   // instead of taking the nodes back one at a time
+   alloc.deallocateChain(m_node->pNext, m_node);
+   m_node->pNext = m_node;
+   m_node->pPrev = m_node;
+   numElements = 0;
 
    // and make sure we're valid after all this
    assert(isValid());
@@ -181,8 +246,8 @@ void List<T> :: clear()
 * LIST :: PUSH BACK
 * Pushes an item onto the back of the list.
 *****************************************************************************/
-template<class T>
-void List<T> :: push_back(T item) throw (const char *)
+template <class T, class Alloc>
+void List <T, Alloc> :: push_back(T item) throw (const char *)
 {
    try
    {
@@ -199,8 +264,8 @@ void List<T> :: push_back(T item) throw (const char *)
 * LIST :: PUSH FRONT
 * Pushes an item onto the front of the list.
 *****************************************************************************/
-template<class T>
-void List<T> :: push_front(T item) throw (const char *)
+template <class T, class Alloc>
+void List <T, Alloc> :: push_front(T item) throw (const char *)
 {
    try
    {
@@ -217,8 +282,8 @@ void List<T> :: push_front(T item) throw (const char *)
 * LIST :: REMOVE
 * Removes an item from the list.
 *****************************************************************************/
-template <class T>
-void List <T> :: remove(ListIterator <T> & item) throw (const char *)
+template <class T, class Alloc>
+void List <T, Alloc> :: remove(ListIterator <T> & item) throw (const char *)
 {
    if (item == end())
       throw "ERROR: unable to remove from an invalid location in a list";
@@ -236,7 +301,7 @@ void List <T> :: remove(ListIterator <T> & item) throw (const char *)
 
    item.p = ptr->pNext;
 
-   delete ptr;
+   alloc.deallocate(ptr);
 
    numElements--;
 }
@@ -245,8 +310,8 @@ void List <T> :: remove(ListIterator <T> & item) throw (const char *)
 * LIST :: FRONT
 * Returns the item at the front of the list
 *****************************************************************************/
-template<class T>
-T & List<T> :: front() const throw (const char *)
+template <class T, class Alloc>
+T & List <T, Alloc> :: front() const throw (const char *)
 {
    if (!empty())
    {
@@ -262,8 +327,8 @@ T & List<T> :: front() const throw (const char *)
 * List :: BACK
 * Returns an item from the back of the list
 *****************************************************************************/
-template<class T>
-T & List<T> :: back() const throw (const char *)
+template <class T, class Alloc>
+T & List <T, Alloc> :: back() const throw (const char *)
 {
    if (!empty())
    {
@@ -279,14 +344,14 @@ T & List<T> :: back() const throw (const char *)
 * List :: INSERT
 * Inserts an item into the middle of the list
 ***************************************************************************/
-template <class T>
-void List<T> :: insert(ListIterator <T> location, const T & item) throw (const char *)
+template <class T, class Alloc>
+void List <T, Alloc> :: insert(ListIterator <T> location, const T & item) throw (const char *)
 {
    Node<T> * newNode;
 
    try
    {
-      newNode = new Node<T>(item);
+      newNode = alloc.allocate(item);
    }
    catch (std::bad_alloc)
    {
@@ -310,8 +375,8 @@ void List<T> :: insert(ListIterator <T> location, const T & item) throw (const c
 * List :: BEGIN
 * Starts at the beginning of the list
 ***************************************************************************/
-template <class T>
-ListIterator <T> List<T> :: begin() const throw (const char *)
+template <class T, class Alloc>
+ListIterator <T> List <T, Alloc> :: begin() const throw (const char *)
 {
    return ListIterator <T>(m_node->pNext);
 }
@@ -320,8 +385,8 @@ ListIterator <T> List<T> :: begin() const throw (const char *)
 * List :: END
 * Starts at the end of the list
 ***************************************************************************/
-template <class T>
-ListIterator <T> List <T> :: end() const
+template <class T, class Alloc>
+ListIterator <T> List <T, Alloc> :: end() const
 {
    return ListIterator <T>(m_node);
 }
@@ -330,8 +395,8 @@ ListIterator <T> List <T> :: end() const
 * List :: RBEGIN
 * Returns an iterator to the last element in the list
 ****************************************************************************/
-template <class T>
-ListIterator <T> List <T> :: rbegin() const
+template <class T, class Alloc>
+ListIterator <T> List <T, Alloc> :: rbegin() const
 {
    return --end();
 }
@@ -340,8 +405,8 @@ ListIterator <T> List <T> :: rbegin() const
 * List :: REND
 * Returns an iterator to past the front element in the list
 ****************************************************************************/
-template <class T>
-ListIterator <T> List <T> :: rend() const
+template <class T, class Alloc>
+ListIterator <T> List <T, Alloc> :: rend() const
 {
    return --begin();
 }
@@ -350,8 +415,8 @@ ListIterator <T> List <T> :: rend() const
 * List :: IS VALID
 * Checks to see that the List is in a valid state
 *****************************************************************************/
-template<class T>
-bool List<T> ::isValid() const
+template <class T, class Alloc>
+bool List <T, Alloc> ::isValid() const
 {
    bool valid = true;
 
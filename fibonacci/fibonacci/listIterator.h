@@ -3,14 +3,15 @@
 
 #include "node.h"
 // class inside my node class for listIterator
-template <class T>
+template <class T, class Alloc>
 class List;
 
 template <class T>
 class ListIterator
 {
 
-   friend class List<T>;
+   template <class U, class Alloc>
+   friend class List;
 
 public:
 
@@ -0,0 +1,244 @@
+/***********************************************************************
+* Header:
+*    NodePool
+* Summary:
+*    Allocators for the nodes of a List. NodeAllocator is the plain
+*    new/delete one; NodePool carves nodes out of slabs and keeps a free
+*    list, so pushing and popping stop going to the heap for each node.
+* Author:
+*     Matthew Burr, Shayla Nelson, Bryan Lopez & Kimberly Stowe
+************************************************************************/
+
+#ifndef NODEPOOL_H
+#define NODEPOOL_H
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include "node.h"
+
+// the first slab holds this many nodes; each one after that is twice
+// the size of the last, up to the maximum
+#define POOL_FIRST_SLAB 16
+#define POOL_MAX_SLAB   4096
+
+/************************************************
+ * NODE ALLOCATOR
+ * Every node is its own new and delete
+ ***********************************************/
+template <class T>
+class NodeAllocator
+{
+public:
+   Node <T> * allocate(const T & data) throw (std::bad_alloc)
+   {
+      return new Node <T>(data);
+   }
+
+   void deallocate(Node <T> * node)
+   {
+      delete node;
+   }
+
+   // frees every node from first up to (not including) stop
+   void deallocateChain(Node <T> * first, Node <T> * stop)
+   {
+      while (first != stop)
+      {
+         Node <T> * next = first->pNext;
+         delete first;
+         first = next;
+      }
+   }
+
+   void swap(NodeAllocator <T> & rhs) throw () { }
+};
+
+/************************************************
+ * NODE POOL
+ * Hands out nodes from slabs. A removed node goes
+ * on a free list for the next insert, and clearing
+ * the whole chain gives the slabs back at once.
+ ***********************************************/
+template <class T>
+class NodePool
+{
+public:
+   // default constructor
+   NodePool() : slabs(NULL), freeList(NULL), nextFree(0), slabSize(0),
+                numRequests(0), numHits(0), numSlabs(0) { }
+
+   // a copy is a new, empty pool: nodes belong to exactly one list
+   NodePool(const NodePool <T> & source)
+      : slabs(NULL), freeList(NULL), nextFree(0), slabSize(0),
+        numRequests(0), numHits(0), numSlabs(0) { }
+
+   // destructor
+   ~NodePool() { releaseSlabs(); }
+
+   // pools are not assigned; the list clears and refills instead
+   NodePool <T> & operator = (const NodePool <T> & rhs) { return *this; }
+
+   // a node holding data, from the free list or the current slab
+   Node <T> * allocate(const T & data) throw (std::bad_alloc);
+
+   // destroys the data and keeps the node for later
+   void deallocate(Node <T> * node);
+
+   // destroys the data in every node from first up to (not including)
+   // stop, then frees all the slabs
+   void deallocateChain(Node <T> * first, Node <T> * stop);
+
+   // exchanges two pools, and with them the nodes they own
+   void swap(NodePool <T> & rhs) throw ();
+
+   // how many nodes were asked for, how many came without a trip to
+   // the heap, and how many slabs that took
+   unsigned long requests() const { return numRequests; }
+   unsigned long hits()     const { return numHits;     }
+   unsigned long slabCount() const { return numSlabs;   }
+   double hitRate() const
+   {
+      return numRequests ? (double)numHits / numRequests : 0.0;
+   }
+
+private:
+   // each slab starts with a pointer to the one allocated before it
+   struct Slab
+   {
+      Slab * pNext;
+   };
+
+   // what a removed node's storage holds once the node is destroyed:
+   // only the link to the next free one
+   struct FreeNode
+   {
+      FreeNode * pNext;
+   };
+
+   Node <T> * slabNodes(Slab * slab) const
+   {
+      return reinterpret_cast <Node <T> *>(slab) + 1;
+   }
+
+   void releaseSlabs();
+
+   Slab * slabs;           // newest slab first
+   FreeNode * freeList;    // the storage of removed nodes
+   size_t nextFree;        // first unused node in the newest slab
+   size_t slabSize;        // nodes in the newest slab
+
+   unsigned long numRequests;
+   unsigned long numHits;
+   unsigned long numSlabs;
+};
+
+/*******************************************
+ * NODE POOL :: ALLOCATE
+ *******************************************/
+template <class T>
+Node <T> * NodePool <T> :: allocate(const T & data) throw (std::bad_alloc)
+{
+   numRequests++;
+
+   Node <T> * node;
+   if (freeList)
+   {
+      FreeNode * free = freeList;
+      freeList = free->pNext;
+      free->~FreeNode();
+      node = reinterpret_cast <Node <T> *>(free);
+      numHits++;
+   }
+   else if (slabs && nextFree < slabSize)
+   {
+      node = slabNodes(slabs) + nextFree++;
+      numHits++;
+   }
+   else
+   {
+      size_t size = slabSize ? slabSize * 2 : POOL_FIRST_SLAB;
+      if (size > POOL_MAX_SLAB)
+         size = POOL_MAX_SLAB;
+
+      // the header is padded to a whole node so the nodes stay aligned
+      Slab * slab = static_cast <Slab *>(::operator new(
+                       sizeof(Node <T>) * (size + 1)));
+      slab->pNext = slabs;
+      slabs = slab;
+      slabSize = size;
+      nextFree = 0;
+      numSlabs++;
+
+      node = slabNodes(slabs) + nextFree++;
+   }
+
+   return new (node) Node <T>(data);
+}
+
+/*******************************************
+ * NODE POOL :: DEALLOCATE
+ *******************************************/
+template <class T>
+void NodePool <T> :: deallocate(Node <T> * node)
+{
+   node->~Node <T>();
+   FreeNode * free = new (static_cast <void *>(node)) FreeNode;
+   free->pNext = freeList;
+   freeList = free;
+}
+
+/*******************************************
+ * NODE POOL :: DEALLOCATE CHAIN
+ *******************************************/
+template <class T>
+void NodePool <T> :: deallocateChain(Node <T> * first, Node <T> * stop)
+{
+   while (first != stop)
+   {
+      Node <T> * next = first->pNext;
+      first->~Node <T>();
+      first = next;
+   }
+
+   releaseSlabs();
+}
+
+/*******************************************
+ * NODE POOL :: SWAP
+ *******************************************/
+template <class T>
+void NodePool <T> :: swap(NodePool <T> & rhs) throw ()
+{
+   // the counts go with the nodes, so allocator() still describes
+   // the list it belongs to
+   std::swap(slabs, rhs.slabs);
+   std::swap(freeList, rhs.freeList);
+   std::swap(nextFree, rhs.nextFree);
+   std::swap(slabSize, rhs.slabSize);
+   std::swap(numRequests, rhs.numRequests);
+   std::swap(numHits, rhs.numHits);
+   std::swap(numSlabs, rhs.numSlabs);
+}
+
+/*******************************************
+ * NODE POOL :: RELEASE SLABS
+ * Every node must already be destroyed
+ *******************************************/
+template <class T>
+void NodePool <T> :: releaseSlabs()
+{
+   while (slabs)
+   {
+      Slab * next = slabs->pNext;
+      ::operator delete(slabs);
+      slabs = next;
+   }
+
+   freeList = NULL;
+   nextFree = 0;
+   slabSize = 0;
+}
+
+#endif // NODEPOOL_H
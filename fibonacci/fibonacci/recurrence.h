@@ -0,0 +1,349 @@
+/***********************************************************************
+* Header:
+*    LinearRecurrence
+* Summary:
+*    Any sequence where each term is a fixed mix of the k before it,
+*       a(n) = c1 a(n-1) + c2 a(n-2) + ... + ck a(n-k),
+*    such as Lucas, Pell or tribonacci numbers. A run of terms is found
+*    by stepping, which only adds onto numbers already there. A single
+*    far-away term uses Kitamasa's method: x^n is reduced modulo the
+*    characteristic polynomial by repeated squaring, taking about k^2
+*    products for each bit of n, and its k coefficients say how a(n)
+*    is made from the starting terms.
+* Author:
+*     Matthew Burr, Shayla Nelson, Bryan Lopez & Kimberly Stowe
+************************************************************************/
+
+#ifndef RECURRENCE_H
+#define RECURRENCE_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "wholeNumber.h"
+
+/************************************************
+ * ADD MULTIPLE and MULTIPLY BY LIMB
+ * The two steps a recurrence needs beyond + and *,
+ * for each kind of number it can be built on. With
+ * uint64_t every term is found modulo 2^64.
+ ***********************************************/
+inline void addMultiple(WholeNumber & sum, const WholeNumber & term, Limb factor)
+{
+   sum.addMultiple(term, factor);
+}
+
+inline void addMultiple(uint64_t & sum, uint64_t term, Limb factor)
+{
+   sum += term * factor;
+}
+
+inline void multiplyByLimb(WholeNumber & number, Limb factor)
+{
+   number.multiplyByLimb(factor);
+}
+
+inline void multiplyByLimb(uint64_t & number, Limb factor)
+{
+   number *= factor;
+}
+
+/************************************************
+ * LINEAR RECURRENCE
+ * The coefficients are single limbs and may not
+ * be negative, since T has no sign. Zero is fine,
+ * as in the Padovan numbers (0, 1, 1).
+ ***********************************************/
+template <class T>
+class LinearRecurrence
+{
+public:
+   // coefficients[i] multiplies a(n - 1 - i), and initial holds
+   // a(0) through a(k - 1)
+   LinearRecurrence(const std::vector <Limb> & coefficients,
+                    const std::vector <T> & initial) throw (const char *);
+
+   // the sequences people ask for by name
+   static LinearRecurrence <T> fibonacci() { return kBonacci(2); }
+   static LinearRecurrence <T> lucas();
+   static LinearRecurrence <T> pell();
+   static LinearRecurrence <T> kBonacci(size_t k) throw (const char *);
+
+   // k, the number of terms each one depends on
+   size_t order() const { return coefficients.size(); }
+
+   // the nth term, by Kitamasa's method
+   T at(uint64_t n) const;
+
+   // visit(n, a(n)) for n from first through last, in order
+   template <class Visit>
+   void forEach(uint64_t first, uint64_t last, Visit visit) const;
+
+private:
+   // r = x^n modulo the characteristic polynomial
+   void power(uint64_t n, std::vector <T> & r) const;
+
+   // r = r x, and r = r^2, each modulo the characteristic polynomial
+   void timesX(std::vector <T> & r) const;
+   void squareModulo(std::vector <T> & r, std::vector <T> & product) const;
+
+   // the term that the coefficients of some x^n stand for
+   T evaluate(const std::vector <T> & r) const;
+
+   // a(n) onto the oldest of the last k terms, in place
+   void step(std::vector <T> & window, size_t & oldest) const;
+
+   std::vector <Limb> coefficients;
+   std::vector <T> initial;
+};
+
+/*******************************************
+ * LINEAR RECURRENCE :: CONSTRUCTOR
+ *******************************************/
+template <class T>
+LinearRecurrence <T> :: LinearRecurrence(const std::vector <Limb> & coefficients,
+                                         const std::vector <T> & initial)
+   throw (const char *) : coefficients(coefficients), initial(initial)
+{
+   if (coefficients.empty())
+      throw "ERROR: a recurrence needs at least one coefficient";
+   if (initial.size() != coefficients.size())
+      throw "ERROR: a recurrence needs one starting term for each coefficient";
+}
+
+/*******************************************
+ * LINEAR RECURRENCE :: NAMED SEQUENCES
+ * Lucas: 2, 1, 3, 4, 7, ...
+ * Pell:  0, 1, 2, 5, 12, ...
+ * k-bonacci: k - 1 zeros, then 1, each term
+ * the sum of the k before it
+ *******************************************/
+template <class T>
+LinearRecurrence <T> LinearRecurrence <T> :: lucas()
+{
+   std::vector <T> initial;
+   initial.push_back(T(2));
+   initial.push_back(T(1));
+   return LinearRecurrence <T>(std::vector <Limb>(2, 1), initial);
+}
+
+template <class T>
+LinearRecurrence <T> LinearRecurrence <T> :: pell()
+{
+   std::vector <Limb> coefficients;
+   coefficients.push_back(2);
+   coefficients.push_back(1);
+   std::vector <T> initial;
+   initial.push_back(T(0));
+   initial.push_back(T(1));
+   return LinearRecurrence <T>(coefficients, initial);
+}
+
+template <class T>
+LinearRecurrence <T> LinearRecurrence <T> :: kBonacci(size_t k)
+   throw (const char *)
+{
+   if (k == 0)
+      throw "ERROR: a recurrence needs at least one coefficient";
+
+   std::vector <T> initial(k, T(0));
+   initial[k - 1] = T(1);
+   return LinearRecurrence <T>(std::vector <Limb>(k, 1), initial);
+}
+
+/*******************************************
+ * LINEAR RECURRENCE :: AT
+ *******************************************/
+template <class T>
+T LinearRecurrence <T> :: at(uint64_t n) const
+{
+   if (n < order())
+      return initial[n];
+
+   std::vector <T> r;
+   power(n, r);
+   return evaluate(r);
+}
+
+/*******************************************
+ * LINEAR RECURRENCE :: FOR EACH
+ * The last k terms sit in a ring. Each step
+ * overwrites the oldest of them in place, so
+ * once the numbers have grown their room the
+ * walk stops allocating.
+ *******************************************/
+template <class T>
+template <class Visit>
+void LinearRecurrence <T> :: forEach(uint64_t first, uint64_t last,
+                                      Visit visit) const
+{
+   if (last < first)
+      return;
+
+   size_t k = order();
+   std::vector <T> window;
+   uint64_t n;
+
+   if (first < k)
+   {
+      window = initial;
+      n = k - 1;
+      for (uint64_t i = first; i < k && i <= last; i++)
+         visit(i, initial[i]);
+   }
+   else
+   {
+      // a(first) through a(first + k - 1), each one more x away
+      std::vector <T> r;
+      power(first, r);
+      for (size_t i = 0; i < k; i++)
+      {
+         if (i)
+            timesX(r);
+         window.push_back(evaluate(r));
+      }
+
+      n = first;
+      for (size_t i = 0; i < k && first + i <= last; i++, n++)
+         visit(first + i, window[i]);
+      n--;
+   }
+
+   // window[oldest] is a(n - k + 1), the newest is just before it
+   size_t oldest = 0;
+   while (n < last)
+   {
+      size_t newest = oldest;
+      step(window, oldest);
+      visit(++n, window[newest]);
+   }
+}
+
+/*******************************************
+ * LINEAR RECURRENCE :: POWER
+ * Left to right over the bits of n
+ *******************************************/
+template <class T>
+void LinearRecurrence <T> :: power(uint64_t n, std::vector <T> & r) const
+{
+   size_t k = order();
+   r.assign(k, T(0));
+   r[0] = T(1);
+   if (n == 0)
+      return;
+
+   int bit = 63;
+   while (!(n >> bit & 1))
+      bit--;
+
+   timesX(r);
+   std::vector <T> product(2 * k - 1, T(0));
+   for (--bit; bit >= 0; --bit)
+   {
+      squareModulo(r, product);
+      if (n >> bit & 1)
+         timesX(r);
+   }
+}
+
+/*******************************************
+ * LINEAR RECURRENCE :: TIMES X
+ * Shifts every coefficient up one, and the
+ * one pushed off the top comes back as
+ * x^k = c1 x^(k-1) + ... + ck
+ *******************************************/
+template <class T>
+void LinearRecurrence <T> :: timesX(std::vector <T> & r) const
+{
+   using std::swap;
+   size_t k = order();
+
+   T top(0);
+   swap(top, r[k - 1]);
+   for (size_t j = k - 1; j > 0; j--)
+      swap(r[j], r[j - 1]);
+
+   for (size_t i = 0; i < k; i++)
+      addMultiple(r[k - 1 - i], top, coefficients[i]);
+}
+
+/*******************************************
+ * LINEAR RECURRENCE :: SQUARE MODULO
+ * Each pair of coefficients is multiplied
+ * once and added twice. The powers from x^k
+ * up are then folded down, highest first.
+ *******************************************/
+template <class T>
+void LinearRecurrence <T> :: squareModulo(std::vector <T> & r,
+                                          std::vector <T> & product) const
+{
+   using std::swap;
+   size_t k = order();
+   const T zero(0);
+
+   for (size_t d = 0; d < product.size(); d++)
+      product[d] = zero;
+
+   for (size_t i = 0; i < k; i++)
+   {
+      T term(r[i]);
+      term *= term;
+      product[2 * i] += term;
+
+      for (size_t j = i + 1; j < k; j++)
+      {
+         term = r[i];
+         term *= r[j];
+         addMultiple(product[i + j], term, 2);
+      }
+   }
+
+   for (size_t d = product.size() - 1; d >= k; d--)
+      for (size_t i = 0; i < k; i++)
+         addMultiple(product[d - 1 - i], product[d], coefficients[i]);
+
+   for (size_t j = 0; j < k; j++)
+      swap(r[j], product[j]);
+}
+
+/*******************************************
+ * LINEAR RECURRENCE :: EVALUATE
+ * x^n = r0 + r1 x + ... means
+ * a(n) = r0 a(0) + r1 a(1) + ...
+ *******************************************/
+template <class T>
+T LinearRecurrence <T> :: evaluate(const std::vector <T> & r) const
+{
+   T sum(0);
+   T term(0);
+   for (size_t j = 0; j < order(); j++)
+   {
+      term = r[j];
+      term *= initial[j];
+      sum += term;
+   }
+   return sum;
+}
+
+/*******************************************
+ * LINEAR RECURRENCE :: STEP
+ * The oldest term, a(n - k), is scaled by ck
+ * and the others are added onto it, which
+ * leaves a(n) where it was
+ *******************************************/
+template <class T>
+void LinearRecurrence <T> :: step(std::vector <T> & window, size_t & oldest) const
+{
+   size_t k = order();
+   T & next = window[oldest];
+   if (coefficients[k - 1] != 1)
+      multiplyByLimb(next, coefficients[k - 1]);
+
+   // a(n - 1 - i) sits i + 1 places before the oldest, going round
+   for (size_t i = 0; i + 1 < k; i++)
+      addMultiple(next, window[(oldest + k - 1 - i) % k], coefficients[i]);
+
+   oldest = (oldest + 1) % k;
+}
+
+#endif // RECURRENCE_H
@@ -0,0 +1,250 @@
+/***********************************************************************
+ * Implementation:
+ *    RUN STATE
+ * Summary:
+ *    Saving and loading the state of a sequential run, and the run
+ *    itself. A save is flushed to the disk before it is renamed into
+ *    place, so the rename never exposes a half-written file, and the
+ *    directory is flushed after, so the rename itself is kept.
+ * Author
+ *    Matthew Burr, Shayla Nelson, Bryan Lopez, Kimberly Stowe
+ **********************************************************************/
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "checkpointTable.h"
+#include "runState.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+#define STATE_MAGIC      "FIBSTATE"
+#define STATE_VERSION    2
+#define STATE_BYTE_ORDER 0x01020304
+
+// look at the clock only this often, since early steps take nanoseconds
+#define CLOCK_STEPS 256
+
+// a save may take at most this share of the time spent stepping
+#define SAVE_SHARE 0.01
+
+/************************************************
+ * WRITE ALL
+ ***********************************************/
+static bool writeAll(FILE * file, const void * data, size_t size)
+{
+   return size == 0 || fwrite(data, 1, size, file) == size;
+}
+
+/************************************************
+ * SYNC DIRECTORY
+ * Flushes the directory holding fileName, which is
+ * where a rename is written down
+ ***********************************************/
+#ifndef _WIN32
+static bool syncDirectory(const char * fileName)
+{
+   const char * slash = strrchr(fileName, '/');
+   string directory = slash == NULL     ? string(".") :
+                      slash == fileName ? string("/") :
+                                          string(fileName, slash - fileName);
+
+   int handle = open(directory.c_str(), O_RDONLY);
+   if (handle < 0)
+      return false;
+   bool good = fsync(handle) == 0;
+   return close(handle) == 0 && good;
+}
+#endif
+
+/************************************************
+ * SAVE RUN STATE
+ * The checksum is over the header, with the
+ * checksum itself taken as zero, and the limbs
+ ***********************************************/
+void saveRunState(const char * fileName, uint64_t k, const WholeNumber & current,
+                  const WholeNumber & next) throw (const char *)
+{
+   size_t currentBytes = current.size() * sizeof(Limb);
+   size_t nextBytes = next.size() * sizeof(Limb);
+
+   StateHeader header;
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, STATE_MAGIC, 8);
+   header.version = STATE_VERSION;
+   header.byteOrder = STATE_BYTE_ORDER;
+   header.index = k;
+   header.currentSize = current.size();
+   header.nextSize = next.size();
+
+   // the header and both numbers in one buffer, to be hashed and
+   // written together
+   vector <char> bytes(sizeof(header) + currentBytes + nextBytes);
+   char * limbs = &bytes[0] + sizeof(header);
+   memcpy(limbs, current.limbs(), currentBytes);
+   memcpy(limbs + currentBytes, next.limbs(), nextBytes);
+   memcpy(&bytes[0], &header, sizeof(header));
+   header.checksum = CheckpointTable::checksum(&bytes[0], bytes.size());
+   memcpy(&bytes[0], &header, sizeof(header));
+
+   string temporary = string(fileName) + ".tmp";
+   FILE * file = fopen(temporary.c_str(), "wb");
+   if (file == NULL)
+      throw "ERROR: unable to create the run state file";
+
+   bool good = writeAll(file, &bytes[0], bytes.size()) &&
+               fflush(file) == 0;
+#ifdef _WIN32
+   good = good && _commit(_fileno(file)) == 0;
+#else
+   good = good && fsync(fileno(file)) == 0;
+#endif
+   good = fclose(file) == 0 && good;
+
+   if (!good)
+   {
+      remove(temporary.c_str());
+      throw "ERROR: unable to write the run state file";
+   }
+
+#ifdef _WIN32
+   good = MoveFileExA(temporary.c_str(), fileName,
+                      MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+   good = rename(temporary.c_str(), fileName) == 0;
+#endif
+   if (!good)
+   {
+      remove(temporary.c_str());
+      throw "ERROR: unable to replace the run state file";
+   }
+
+#ifndef _WIN32
+   // MOVEFILE_WRITE_THROUGH does this on Windows
+   if (!syncDirectory(fileName))
+      throw "ERROR: unable to write the run state file";
+#endif
+}
+
+/************************************************
+ * LOAD RUN STATE
+ ***********************************************/
+bool loadRunState(const char * fileName, uint64_t & k, WholeNumber & current,
+                  WholeNumber & next) throw (const char *)
+{
+   FILE * file = fopen(fileName, "rb");
+   if (file == NULL)
+      return false;
+
+   StateHeader header;
+   vector <char> bytes;
+   bool good = fread(&header, sizeof(header), 1, file) == 1 &&
+               memcmp(header.magic, STATE_MAGIC, 8) == 0;
+   if (good && (header.version != STATE_VERSION ||
+                header.byteOrder != STATE_BYTE_ORDER))
+   {
+      fclose(file);
+      throw "ERROR: the run state file was written by a different version or machine";
+   }
+
+   // sizes from a damaged header must not make us allocate wildly
+   const uint64_t most = (uint64_t)1 << 40;
+   good = good && header.currentSize > 0 && header.nextSize > 0 &&
+          header.currentSize < most && header.nextSize < most;
+   size_t limbBytes = 0;
+   if (good)
+   {
+      limbBytes = (size_t)(header.currentSize + header.nextSize) * sizeof(Limb);
+      bytes.resize(sizeof(header) + limbBytes);
+      good = fread(&bytes[sizeof(header)], 1, limbBytes, file) == limbBytes &&
+             fgetc(file) == EOF;
+   }
+   fclose(file);
+
+   if (!good)
+      throw "ERROR: the run state file is damaged";
+
+   // hashed as it was written, before the checksum went in
+   StateHeader hashed = header;
+   hashed.checksum = 0;
+   memcpy(&bytes[0], &hashed, sizeof(hashed));
+   if (CheckpointTable::checksum(&bytes[0], bytes.size()) != header.checksum)
+      throw "ERROR: the run state file is damaged";
+
+   const Limb * first = reinterpret_cast <const Limb *>(&bytes[sizeof(header)]);
+   k = header.index;
+   current = WholeNumber(WholeNumberView(first, (size_t)header.currentSize));
+   next = WholeNumber(WholeNumberView(first + header.currentSize,
+                                      (size_t)header.nextSize));
+   return true;
+}
+
+/************************************************
+ * FIBONACCI RESUMABLE
+ * The same loop as fibonacciSequential, stopping
+ * now and then to save. A save that took s seconds
+ * is not followed by another for at least 100 s,
+ * however few steps or seconds were asked for,
+ * which keeps the saving under 1% of the run.
+ ***********************************************/
+WholeNumber fibonacciResumable(uint64_t n, const RunOptions & options)
+   throw (const char *)
+{
+   typedef chrono::steady_clock Clock;
+
+   uint64_t k = 0;
+   WholeNumber a(0);   // F(k)
+   WholeNumber b(1);   // F(k+1)
+   if (options.fileName && options.resume)
+   {
+      loadRunState(options.fileName, k, a, b);
+      if (k > n)
+         throw "ERROR: the saved run is already past that index";
+   }
+
+   double quiet = 0.0;   // seconds the last save buys us
+   uint64_t lastSaveStep = k;
+   Clock::time_point lastSave = Clock::now();
+
+   while (k < n)
+   {
+      a += b;
+      swap(a, b);
+      k++;
+
+      if (options.fileName == NULL || k == n)
+         continue;
+
+      // the clock is read only every so often, or once enough steps
+      // have gone by
+      bool stepsUp = options.everySteps && k - lastSaveStep >= options.everySteps;
+      if (!stepsUp && (options.everySeconds <= 0.0 || k % CLOCK_STEPS))
+         continue;
+
+      Clock::time_point start = Clock::now();
+      double since = chrono::duration <double>(start - lastSave).count();
+      bool timeUp = options.everySeconds > 0.0 && since >= options.everySeconds;
+      if (!(stepsUp || timeUp) || since < quiet)
+         continue;
+
+      saveRunState(options.fileName, k, a, b);
+      lastSave = Clock::now();
+      lastSaveStep = k;
+      quiet = chrono::duration <double>(lastSave - start).count() / SAVE_SHARE;
+   }
+
+   // the finished state, so resuming the same run is instant
+   if (options.fileName)
+      saveRunState(options.fileName, k, a, b);
+
+   return a;
+}
@@ -0,0 +1,69 @@
+/***********************************************************************
+ * Header:
+ *    RUN STATE
+ * Summary:
+ *    Lets the long, one-step-at-a-time Fibonacci loop survive being
+ *    stopped. Every so often it saves k, F(k) and F(k+1) to a file,
+ *    and a later run can pick up from there. A save goes to a temporary
+ *    file that is then renamed over the old one, so a crash in the
+ *    middle of saving leaves the last good state behind.
+ *
+ *    The file, all in this machine's byte order:
+ *       StateHeader, the limbs of F(k), then the limbs of F(k+1)
+ *    with a checksum over all of it but the checksum itself.
+ * Author
+ *    Matthew Burr, Shayla Nelson, Bryan Lopez, Kimberly Stowe
+ ************************************************************************/
+
+#ifndef RUNSTATE_H
+#define RUNSTATE_H
+
+#include <cstdint>
+#include "wholeNumber.h"
+
+/************************************************
+ * STATE HEADER
+ ***********************************************/
+struct StateHeader
+{
+   char     magic[8];       // "FIBSTATE"
+   uint32_t version;        // 2
+   uint32_t byteOrder;      // 0x01020304 as this machine writes it
+   uint64_t index;          // k
+   uint64_t currentSize;    // limbs in F(k)
+   uint64_t nextSize;       // limbs in F(k+1)
+   uint64_t checksum;       // of the rest of the header and the limbs
+};
+
+/************************************************
+ * RUN OPTIONS
+ * How often to save: after so many steps, or so
+ * many seconds, whichever comes first. Zero turns
+ * either one off. Saves never come so often that
+ * writing them takes more than 1% of the time.
+ ***********************************************/
+struct RunOptions
+{
+   RunOptions() : fileName(NULL), everySteps(0), everySeconds(60.0),
+                  resume(false) { }
+
+   const char * fileName;   // where the state goes
+   uint64_t everySteps;
+   double everySeconds;
+   bool resume;             // start from the file if there is one
+};
+
+// writes k, F(k) and F(k+1), replacing any earlier state in one step
+void saveRunState(const char * fileName, uint64_t k, const WholeNumber & current,
+                  const WholeNumber & next) throw (const char *);
+
+// reads them back; false if there is no such file, and throws if the
+// file is there but damaged
+bool loadRunState(const char * fileName, uint64_t & k, WholeNumber & current,
+                  WholeNumber & next) throw (const char *);
+
+// F(n) by adding one step at a time, saving as it goes
+WholeNumber fibonacciResumable(uint64_t n, const RunOptions & options)
+   throw (const char *);
+
+#endif // RUNSTATE_H
@@ -0,0 +1,252 @@
+/***********************************************************************
+ * Implementation:
+ *    THREAD POOL
+ * Summary:
+ *    The workers, stealing, and waiting for a TaskGroup. Every deque
+ *    has its own lock, so workers only meet on a lock when one of them
+ *    is stealing.
+ * Author
+ *    Matthew Burr, Shayla Nelson, Bryan Lopez, Kimberly Stowe
+ **********************************************************************/
+
+#include <new>
+#include "threadPool.h"
+using namespace std;
+
+thread_local ThreadPool * ThreadPool::currentPool = NULL;
+thread_local int ThreadPool::workerIndex = -1;
+unsigned ThreadPool::sharedSize = 0;
+
+/************************************************
+ * THREAD POOL :: CONSTRUCTOR
+ ***********************************************/
+ThreadPool::ThreadPool(unsigned numThreads) throw (const char *)
+   : queued(0), stopping(false)
+{
+   if (numThreads == 0)
+      numThreads = thread::hardware_concurrency();
+   if (numThreads == 0)
+      numThreads = 1;
+
+   try
+   {
+      for (unsigned i = 0; i < numThreads; i++)
+         workers.push_back(unique_ptr <Worker>(new Worker));
+      for (unsigned i = 0; i < numThreads; i++)
+         threads.push_back(thread(&ThreadPool::workerLoop, this, (int)i));
+   }
+   catch (...)
+   {
+      {
+         lock_guard <mutex> guard(sleepLock);
+         stopping = true;
+      }
+      wake.notify_all();
+      for (size_t i = 0; i < threads.size(); i++)
+         threads[i].join();
+      throw "ERROR: unable to start the worker threads";
+   }
+}
+
+/************************************************
+ * THREAD POOL :: DESTRUCTOR
+ ***********************************************/
+ThreadPool::~ThreadPool()
+{
+   {
+      lock_guard <mutex> guard(sleepLock);
+      stopping = true;
+   }
+   wake.notify_all();
+
+   for (size_t i = 0; i < threads.size(); i++)
+      threads[i].join();
+}
+
+/************************************************
+ * THREAD POOL :: SHARED
+ ***********************************************/
+ThreadPool & ThreadPool::shared()
+{
+   static ThreadPool pool(sharedSize);
+   return pool;
+}
+
+/************************************************
+ * THREAD POOL :: RUN
+ * A worker puts new tasks on its own deque, where
+ * it will find them first and others can steal
+ * them; anyone else joins the back of the queue.
+ ***********************************************/
+void ThreadPool::run(TaskGroup & group, const function <void ()> & work)
+{
+   Task task;
+   task.work = work;
+   task.group = &group;
+   group.pending++;
+
+   int index = self();
+   if (index >= 0)
+   {
+      lock_guard <mutex> guard(workers[index]->lock);
+      workers[index]->tasks.push_back(task);
+   }
+   else
+   {
+      lock_guard <mutex> guard(queueLock);
+      queue.push_back(task);
+   }
+   queued++;
+
+   // taking the lock means no one can be between checking queued and
+   // going to sleep, so the wake cannot be missed
+   {
+      lock_guard <mutex> guard(sleepLock);
+   }
+   wake.notify_one();
+}
+
+/************************************************
+ * THREAD POOL :: WAIT
+ * Helps with whatever is queued, not just this
+ * group, since the group's tasks may be waiting
+ * on the others
+ ***********************************************/
+void ThreadPool::wait(TaskGroup & group) throw (const char *)
+{
+   int index = self();
+   while (!group.done())
+   {
+      Task task;
+      if (findTask(task, index))
+      {
+         execute(task);
+         continue;
+      }
+
+      unique_lock <mutex> guard(sleepLock);
+      wake.wait(guard, [&] { return group.done() || queued.load() > 0; });
+   }
+
+   const char * error = group.error.exchange(NULL);
+   if (error)
+      throw error;
+}
+
+/************************************************
+ * THREAD POOL :: FIND TASK
+ * Newest from our own deque, then oldest from the
+ * queue, then oldest from the next worker that has
+ * anything
+ ***********************************************/
+bool ThreadPool::findTask(Task & task, int index)
+{
+   if (queued.load() == 0)
+      return false;
+
+   if (index >= 0)
+   {
+      Worker & mine = *workers[index];
+      lock_guard <mutex> guard(mine.lock);
+      if (!mine.tasks.empty())
+      {
+         task = std::move(mine.tasks.back());
+         mine.tasks.pop_back();
+         queued--;
+         return true;
+      }
+   }
+
+   {
+      lock_guard <mutex> guard(queueLock);
+      if (!queue.empty())
+      {
+         task = std::move(queue.front());
+         queue.pop_front();
+         queued--;
+         return true;
+      }
+   }
+
+   size_t count = workers.size();
+   for (size_t i = 1; i <= count; i++)
+   {
+      Worker & victim = *workers[(index + i) % count];
+      lock_guard <mutex> guard(victim.lock);
+      if (!victim.tasks.empty())
+      {
+         task = std::move(victim.tasks.front());
+         victim.tasks.pop_front();
+         queued--;
+         return true;
+      }
+   }
+
+   return false;
+}
+
+/************************************************
+ * THREAD POOL :: EXECUTE
+ * The group may be gone the moment its count
+ * reaches zero, so nothing touches it after that
+ ***********************************************/
+void ThreadPool::execute(Task & task)
+{
+   TaskGroup * group = task.group;
+   const char * error = NULL;
+   try
+   {
+      task.work();
+   }
+   catch (const char * thrown)
+   {
+      error = thrown;
+   }
+   catch (const std::bad_alloc &)
+   {
+      error = "ERROR: out of memory in a worker thread";
+   }
+   catch (...)
+   {
+      // anything else must still count the task as done
+      error = "ERROR: a task failed in a worker thread";
+   }
+
+   if (error)
+   {
+      const char * none = NULL;
+      group->error.compare_exchange_strong(none, error);
+   }
+
+   if (--group->pending == 0)
+   {
+      {
+         lock_guard <mutex> guard(sleepLock);
+      }
+      wake.notify_all();
+   }
+}
+
+/************************************************
+ * THREAD POOL :: WORKER LOOP
+ ***********************************************/
+void ThreadPool::workerLoop(int index)
+{
+   currentPool = this;
+   workerIndex = index;
+
+   for (;;)
+   {
+      Task task;
+      if (findTask(task, index))
+      {
+         execute(task);
+         continue;
+      }
+
+      unique_lock <mutex> guard(sleepLock);
+      wake.wait(guard, [&] { return stopping || queued.load() > 0; });
+      if (stopping && queued.load() == 0)
+         return;
+   }
+}
@@ -0,0 +1,124 @@
+/***********************************************************************
+ * Header:
+ *    THREAD POOL
+ * Summary:
+ *    A fixed set of worker threads that share out tasks by stealing.
+ *    Each worker keeps its own deque: it takes its newest task from the
+ *    back, and an idle worker steals the oldest one from the front.
+ *    Tasks from outside the pool wait in a first-come, first-served
+ *    queue. A thread waiting on a TaskGroup runs tasks itself instead
+ *    of sleeping, so a task may start tasks of its own and wait on them.
+ * Author
+ *    Matthew Burr, Shayla Nelson, Bryan Lopez, Kimberly Stowe
+ ************************************************************************/
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/************************************************
+ * TASK GROUP
+ * The tasks a caller waits on together. The first
+ * error one of them throws is thrown again by wait.
+ ***********************************************/
+class TaskGroup
+{
+public:
+   TaskGroup() : pending(0), error(NULL) { }
+
+   // have all of the tasks finished?
+   bool done() const { return pending.load() == 0; }
+
+private:
+   friend class ThreadPool;
+
+   // a group is waited on in place, never copied
+   TaskGroup(const TaskGroup &);
+   TaskGroup & operator = (const TaskGroup &);
+
+   std::atomic <size_t> pending;
+   std::atomic <const char *> error;
+};
+
+/************************************************
+ * THREAD POOL
+ ***********************************************/
+class ThreadPool
+{
+public:
+   // threads of 0 means one for each core
+   explicit ThreadPool(unsigned threads = 0) throw (const char *);
+
+   // finishes what is queued, then stops the workers
+   ~ThreadPool();
+
+   // how many worker threads there are
+   unsigned size() const { return (unsigned)threads.size(); }
+
+   // queues a task as part of group
+   void run(TaskGroup & group, const std::function <void ()> & work);
+
+   // runs tasks until everything in group is finished
+   void wait(TaskGroup & group) throw (const char *);
+
+   // the pool the Fibonacci functions use, made on first use
+   static ThreadPool & shared();
+
+   // the number of threads for the shared pool; only counts before
+   // the first call to shared()
+   static void setSharedSize(unsigned threads) { sharedSize = threads; }
+
+private:
+   struct Task
+   {
+      std::function <void ()> work;
+      TaskGroup * group;
+   };
+
+   struct Worker
+   {
+      std::mutex lock;
+      std::deque <Task> tasks;
+   };
+
+   ThreadPool(const ThreadPool &);
+   ThreadPool & operator = (const ThreadPool &);
+
+   // the worker number of this thread, or -1 if it is not one of ours
+   int self() const { return currentPool == this ? workerIndex : -1; }
+
+   // takes a task from our own deque, the queue, or another worker
+   bool findTask(Task & task, int index);
+
+   // runs a task and counts it off its group
+   void execute(Task & task);
+
+   // what each worker thread does until the pool is destroyed
+   void workerLoop(int index);
+
+   std::vector <std::unique_ptr <Worker> > workers;
+   std::vector <std::thread> threads;
+
+   std::mutex queueLock;             // for the tasks from outside
+   std::deque <Task> queue;
+
+   std::mutex sleepLock;             // idle threads wait on wake
+   std::condition_variable wake;
+   std::atomic <size_t> queued;      // tasks in any deque or the queue
+   bool stopping;
+
+   static thread_local ThreadPool * currentPool;
+   static thread_local int workerIndex;
+   static unsigned sharedSize;
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,468 @@
+/***********************************************************************
+* Header:
+*    UnrolledList
+* Summary:
+*    An unrolled version of List: each node holds up to CHUNK elements
+*    in a small array instead of just one, so a long list of small
+*    things like ints spends far less on pointers and walks through
+*    far fewer cache lines. Inserting and removing at an iterator are
+*    still constant time, since a chunk never holds more than CHUNK.
+* Author:
+*     Matthew Burr, Shayla Nelson, Bryan Lopez & Kimberly Stowe
+************************************************************************/
+
+#ifndef UNROLLEDLIST_H
+#define UNROLLEDLIST_H
+
+#include <cassert>
+#include <new>
+
+// the number of elements in a node, unless the list asks for another
+#define MAXNODES 7
+
+/************************************************
+ * UNROLLED NODE
+ * A node holding up to CHUNK elements in order
+ ***********************************************/
+template <class T, int CHUNK>
+class UnrolledNode
+{
+public:
+   UnrolledNode() : count(0), pPrev(NULL), pNext(NULL) { }
+
+   // member variables
+   T data[CHUNK];
+   int count;
+   UnrolledNode * pPrev;
+   UnrolledNode * pNext;
+};
+
+template <class T, int CHUNK>
+class UnrolledList;
+
+/************************************************
+ * UNROLLED ITERATOR
+ * A node and a spot in it. Moving steps through
+ * the chunk first and only then follows pNext or
+ * pPrev.
+ ***********************************************/
+template <class T, int CHUNK = MAXNODES>
+class UnrolledIterator
+{
+   friend class UnrolledList <T, CHUNK>;
+
+public:
+   // default constructor
+   UnrolledIterator() : p(NULL), index(0) { }
+
+   // initialize to direct p to some item
+   UnrolledIterator(UnrolledNode <T, CHUNK> * p, int index = 0)
+      : p(p), index(index) { }
+
+   bool operator == (const UnrolledIterator & rhs) const
+   {
+      return rhs.p == p && rhs.index == index;
+   }
+
+   bool operator != (const UnrolledIterator & rhs) const
+   {
+      return !(*this == rhs);
+   }
+
+   // dereference operator
+   T & operator * () { return p->data[index]; }
+
+   // prefix increment
+   UnrolledIterator & operator ++ ()
+   {
+      if (++index >= p->count)
+      {
+         p = p->pNext;
+         index = 0;
+      }
+      return *this;
+   }
+
+   // postfix increment
+   UnrolledIterator operator ++ (int postfix)
+   {
+      UnrolledIterator tmp(*this);
+      ++*this;
+      return tmp;
+   }
+
+   // prefix decrement. The sentinel has no elements, so
+   // stepping back onto it lands on index 0
+   UnrolledIterator & operator -- ()
+   {
+      if (index > 0)
+         --index;
+      else
+      {
+         p = p->pPrev;
+         index = p->count ? p->count - 1 : 0;
+      }
+      return *this;
+   }
+
+   // postfix decrement
+   UnrolledIterator operator -- (int postfix)
+   {
+      UnrolledIterator tmp(*this);
+      --*this;
+      return tmp;
+   }
+
+private:
+   UnrolledNode <T, CHUNK> * p;
+   int index;
+};
+
+/************************************************
+ * UNROLLED LIST
+ * The same interface as List, over chunked nodes.
+ * Like List it is circular, with an empty sentinel
+ * node standing for end().
+ ***********************************************/
+template <class T, int CHUNK = MAXNODES>
+class UnrolledList
+{
+public:
+   typedef UnrolledIterator <T, CHUNK> iterator;
+
+   // default constructor
+   UnrolledList() throw (const char *);
+
+   // copy constructor
+   UnrolledList(const UnrolledList & source) throw (const char *);
+
+   // move constructor: takes the nodes, leaving source empty
+   UnrolledList(UnrolledList && source) throw (const char *);
+
+   // destructor
+   ~UnrolledList();
+
+   // assignment operator
+   UnrolledList & operator = (const UnrolledList & source)
+      throw (const char *);
+
+   // move assignment: trades nodes with source
+   UnrolledList & operator = (UnrolledList && source) throw ()
+   {
+      swap(source);
+      return *this;
+   }
+
+   // exchanges the contents of two lists without copying
+   void swap(UnrolledList & rhs) throw ();
+
+   // additional methods
+   bool empty() const { return numElements == 0; }
+   int  size()  const { return numElements;      }
+
+   // how many nodes hold the elements
+   int  nodes() const { return numNodes;         }
+
+   // clears the contents of list
+   void clear();
+
+   // adds a value to the back of the list
+   void push_back(const T & item) throw (const char *) { insert(end(), item); }
+
+   // adds a value to the front of the list
+   void push_front(const T & item) throw (const char *) { insert(begin(), item); }
+
+   // removes an item, leaving the iterator on the one after it
+   void remove(iterator & item) throw (const char *);
+
+   // returns the front item of a list
+   T & front() const throw (const char *);
+
+   // returns the back item of a list
+   T & back() const throw (const char *);
+
+   // inserts an item in front of location
+   void insert(iterator location, const T & item) throw (const char *);
+
+   // iterators, as for List
+   iterator begin()  const { return iterator(m_node->pNext);           }
+   iterator end()    const { return iterator(m_node);                  }
+   iterator rbegin() const { return --end();                           }
+   iterator rend()   const { return iterator(m_node);                  }
+
+private:
+   typedef UnrolledNode <T, CHUNK> Node;
+
+   // a new empty node after this one
+   Node * addNodeAfter(Node * node) throw (const char *);
+
+   // unhooks and frees a node
+   void removeNode(Node * node);
+
+   // member variables
+   Node * m_node;
+   int numElements;
+   int numNodes;
+};
+
+/*******************************************
+ * UNROLLED LIST :: DEFAULT CONSTRUCTOR
+ *******************************************/
+template <class T, int CHUNK>
+UnrolledList <T, CHUNK> :: UnrolledList() throw (const char *)
+   : m_node(NULL), numElements(0), numNodes(0)
+{
+   try
+   {
+      m_node = new Node;
+   }
+   catch (std::bad_alloc)
+   {
+      throw "ERROR: unable to allocate a new node for a list";
+   }
+   m_node->pNext = m_node;
+   m_node->pPrev = m_node;
+}
+
+/*******************************************
+ * UNROLLED LIST :: COPY CONSTRUCTOR
+ *******************************************/
+template <class T, int CHUNK>
+UnrolledList <T, CHUNK> :: UnrolledList(const UnrolledList & source)
+   throw (const char *) : m_node(NULL), numElements(0), numNodes(0)
+{
+   UnrolledList empty;
+   swap(empty);
+   *this = source;
+}
+
+/*******************************************
+ * UNROLLED LIST :: MOVE CONSTRUCTOR
+ *******************************************/
+template <class T, int CHUNK>
+UnrolledList <T, CHUNK> :: UnrolledList(UnrolledList && source)
+   throw (const char *) : m_node(NULL), numElements(0), numNodes(0)
+{
+   UnrolledList empty;
+   swap(empty);
+   swap(source);
+}
+
+/*******************************************
+ * UNROLLED LIST :: DESTRUCTOR
+ *******************************************/
+template <class T, int CHUNK>
+UnrolledList <T, CHUNK> :: ~UnrolledList()
+{
+   if (m_node)
+   {
+      clear();
+      delete m_node;
+   }
+}
+
+/*******************************************
+ * UNROLLED LIST :: ASSIGNMENT OPERATOR
+ * Packs the copy into full chunks
+ *******************************************/
+template <class T, int CHUNK>
+UnrolledList <T, CHUNK> & UnrolledList <T, CHUNK> :: operator =
+   (const UnrolledList & source) throw (const char *)
+{
+   if (this == &source)
+      return *this;
+
+   clear();
+   Node * last = m_node;
+   for (Node * p = source.m_node->pNext; p != source.m_node; p = p->pNext)
+      for (int i = 0; i < p->count; i++)
+      {
+         if (last == m_node || last->count == CHUNK)
+            last = addNodeAfter(last);
+         last->data[last->count++] = p->data[i];
+      }
+   numElements = source.numElements;
+
+   return *this;
+}
+
+/*******************************************
+ * UNROLLED LIST :: SWAP
+ *******************************************/
+template <class T, int CHUNK>
+void UnrolledList <T, CHUNK> :: swap(UnrolledList & rhs) throw ()
+{
+   Node * tempNode = m_node;
+   m_node = rhs.m_node;
+   rhs.m_node = tempNode;
+
+   int temp = numElements;
+   numElements = rhs.numElements;
+   rhs.numElements = temp;
+
+   temp = numNodes;
+   numNodes = rhs.numNodes;
+   rhs.numNodes = temp;
+}
+
+/*******************************************
+ * UNROLLED LIST :: CLEAR
+ *******************************************/
+template <class T, int CHUNK>
+void UnrolledList <T, CHUNK> :: clear()
+{
+   while (m_node->pNext != m_node)
+      removeNode(m_node->pNext);
+   numElements = 0;
+}
+
+/*******************************************
+ * UNROLLED LIST :: FRONT
+ *******************************************/
+template <class T, int CHUNK>
+T & UnrolledList <T, CHUNK> :: front() const throw (const char *)
+{
+   if (empty())
+      throw "ERROR: unable to access data from an empty list";
+   return m_node->pNext->data[0];
+}
+
+/*******************************************
+ * UNROLLED LIST :: BACK
+ *******************************************/
+template <class T, int CHUNK>
+T & UnrolledList <T, CHUNK> :: back() const throw (const char *)
+{
+   if (empty())
+      throw "ERROR: unable to access data from an empty list";
+   Node * last = m_node->pPrev;
+   return last->data[last->count - 1];
+}
+
+/*******************************************
+ * UNROLLED LIST :: INSERT
+ * A full chunk is split in half first, so
+ * an insert moves at most CHUNK elements
+ *******************************************/
+template <class T, int CHUNK>
+void UnrolledList <T, CHUNK> :: insert(iterator location, const T & item)
+   throw (const char *)
+{
+   Node * node = location.p;
+   int index = location.index;
+
+   if (NULL == node)
+      throw "ERROR: invalid pointer";
+
+   // at the end we append to the last chunk, or start a new one
+   if (node == m_node)
+   {
+      node = m_node->pPrev;
+      if (node == m_node || node->count == CHUNK)
+         node = addNodeAfter(node);
+      index = node->count;
+   }
+
+   if (node->count == CHUNK)
+   {
+      Node * split = addNodeAfter(node);
+      int half = CHUNK / 2;
+      for (int i = half; i < CHUNK; i++)
+         split->data[i - half] = node->data[i];
+      split->count = CHUNK - half;
+      node->count = half;
+
+      if (index > half)
+      {
+         node = split;
+         index -= half;
+      }
+   }
+
+   for (int i = node->count; i > index; i--)
+      node->data[i] = node->data[i - 1];
+   node->data[index] = item;
+   node->count++;
+   numElements++;
+}
+
+/*******************************************
+ * UNROLLED LIST :: REMOVE
+ * A chunk that drops below half full takes in
+ * the next one when they fit together, which
+ * keeps the chunks from thinning out
+ *******************************************/
+template <class T, int CHUNK>
+void UnrolledList <T, CHUNK> :: remove(iterator & item) throw (const char *)
+{
+   Node * node = item.p;
+   int index = item.index;
+
+   if (NULL == node || node == m_node || index >= node->count)
+      throw "ERROR: unable to remove from an invalid location in a list";
+
+   for (int i = index; i < node->count - 1; i++)
+      node->data[i] = node->data[i + 1];
+   node->count--;
+   numElements--;
+
+   if (node->count == 0)
+   {
+      item = iterator(node->pNext);
+      removeNode(node);
+      return;
+   }
+
+   Node * next = node->pNext;
+   if (node->count < CHUNK / 2 && next != m_node &&
+       node->count + next->count <= CHUNK)
+   {
+      for (int i = 0; i < next->count; i++)
+         node->data[node->count + i] = next->data[i];
+      node->count += next->count;
+      removeNode(next);
+   }
+
+   item = index < node->count ? iterator(node, index)
+                              : iterator(node->pNext);
+}
+
+/*******************************************
+ * UNROLLED LIST :: ADD NODE AFTER
+ *******************************************/
+template <class T, int CHUNK>
+UnrolledNode <T, CHUNK> * UnrolledList <T, CHUNK> :: addNodeAfter(Node * node)
+   throw (const char *)
+{
+   Node * newNode;
+   try
+   {
+      newNode = new Node;
+   }
+   catch (std::bad_alloc)
+   {
+      throw "ERROR: unable to allocate a new node for a list";
+   }
+
+   newNode->pPrev = node;
+   newNode->pNext = node->pNext;
+   node->pNext->pPrev = newNode;
+   node->pNext = newNode;
+   numNodes++;
+
+   return newNode;
+}
+
+/*******************************************
+ * UNROLLED LIST :: REMOVE NODE
+ *******************************************/
+template <class T, int CHUNK>
+void UnrolledList <T, CHUNK> :: removeNode(Node * node)
+{
+   node->pPrev->pNext = node->pNext;
+   node->pNext->pPrev = node->pPrev;
+   delete node;
+   numNodes--;
+}
+
+#endif // UNROLLEDLIST_H
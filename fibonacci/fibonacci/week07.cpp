@@ -14,16 +14,33 @@
 #include <iomanip>      // for SETW
 #include <string>       // for the String class
 #include <cassert>      // for ASSERT
+#include <cstdlib>      // for RAND
 #include "list.h"       // your List class should be in list.h
+#include "unrolledList.h" // the chunked version of List
 #include "fibonacci.h"  // your fibonacci() function
+#include "commandLine.h" // for running without the menu
+#include "threadPool.h" // for the batch and nested tasks
+#include "checkpointCache.h" // for remembering Fibonacci pairs
+#include "checkpointTable.h" // for checkpoints saved in a file
+#include "runState.h"   // for stopping and resuming a long loop
+#include "fibonacciMod.h" // for F(n) mod m
+#include "recurrence.h" // for Lucas, Pell and other recurrences
+#include "fibonacciDigits.h" // for the first and last digits
+#include <cstddef>      // for OFFSETOF
+#include <cstdio>       // for REMOVE
+#include <fstream>      // for damaging a table on purpose
+#include <stdexcept>    // for LENGTH_ERROR
+#include <vector>       // for the batch indices
 using namespace std;
 
 
-// prototypes for our four test functions
+// prototypes for our five test functions
 void testSimple();
 void testPush();
 void testIterate();
 void testInsertRemove();
+void testFibonacci();
+void testUnrolled();
 
 // To get your program to compile, you might need to comment out a few
 // of these. The idea is to help you avoid too many compile errors at once.
@@ -33,19 +50,27 @@ void testInsertRemove();
 #define TEST2   // for testPush()
 #define TEST3   // for testIterate()
 #define TEST4   // for testInsertRemove()
+#define TEST5   // for testFibonacci()
+#define TEST6   // for testUnrolled()
 
 /**********************************************************************
  * MAIN
- * This is just a simple menu to launch a collection of tests
+ * This is just a simple menu to launch a collection of tests. Given
+ * any arguments, it skips the menu and does what they ask instead.
  ***********************************************************************/
-int main()
+int main(int argc, const char * argv[])
 {
+   if (argc > 1)
+      return fibonacciCommandLine(argc, argv);
+
    // menu
    cout << "Select the test you want to run:\n";
    cout << "\t1. Just create and destroy a List\n";
    cout << "\t2. The above plus push items onto the List\n";
    cout << "\t3. The above plus iterate through the List\n";
    cout << "\t4. The above plus insert and remove items from the list\n";
+   cout << "\t5. Check fast Fibonacci against the sequential loop\n";
+   cout << "\t6. Check the unrolled List against List\n";
    cout << "\ta. Fibonacci\n";
 
    // select
@@ -73,6 +98,14 @@ int main()
          testInsertRemove();
          cout << "Test 4 complete\n";
          break;
+      case '5':
+         testFibonacci();
+         cout << "Test 5 complete\n";
+         break;
+      case '6':
+         testUnrolled();
+         cout << "Test 6 complete\n";
+         break;
       default:
          cout << "Unrecognized command, exiting...\n";
    }
@@ -129,6 +162,28 @@ void testSimple()
       cout << "\tEmpty? " << (l4.empty() ? "Yes" : "No") << endl;
       cout << "\tFront: " << l4.front()                  << endl;
       cout << "\tBack:  " << l4.back()                   << endl;
+
+      // test 1.e: move the List, which hands over the nodes
+      cout << "Move a double List into a new one\n";
+      List <double> l5(std::move(l4));
+      cout << "\tSize:  " << l5.size()                   << endl;
+      cout << "\tFront: " << l5.front()                  << endl;
+      cout << "\tMoved-from empty? " << (l4.empty() ? "Yes" : "No") << endl;
+      l4.swap(l5);
+      cout << "\tSwapped back, size: " << l4.size()      << endl;
+
+      // test 1.f: removed nodes are reused by the pool
+      cout << "Push and remove 1000 times on an int List\n";
+      List <int> l6;
+      for (int i = 0; i < 1000; i++)
+      {
+         l6.push_back(i);
+         ListIterator <int> it = l6.begin();
+         l6.remove(it);
+      }
+      cout << "\tSlabs: " << l6.allocator().slabCount()  << endl;
+      cout << "\tHits:  " << l6.allocator().hits() << " of "
+           << l6.allocator().requests()                  << endl;
    }
    catch (const char * error)
    {
@@ -402,3 +457,640 @@ void testInsertRemove()
    while (command != '!'); 
 #endif // TEST4
 }
+
+/*******************************************
+ * TEST FIBONACCI
+ * The fast Fibonacci numbers must agree with the
+ * ones we get by adding one step at a time
+ *******************************************/
+void testFibonacci()
+{
+#ifdef TEST5
+   try
+   {
+      // every index up to a few hundred, which covers the small cases
+      for (uint64_t n = 0; n <= 500; n++)
+         assert(fibonacciAt(n) == fibonacciSequential(n));
+      cout << "\tF(0) through F(500) match\n";
+
+      // and a few larger ones
+      uint64_t large[] = { 1000, 1023, 1024, 4097, 10000 };
+      for (int i = 0; i < 5; i++)
+      {
+         assert(fibonacciAt(large[i]) == fibonacciSequential(large[i]));
+         cout << "\tF(" << large[i] << ") matches\n";
+      }
+
+      // F(m + n) = F(m) F(n + 1) + F(m - 1) F(n) uses products of
+      // very different sizes, and squares through the operator
+      WholeNumber left = fibonacciAt(3000) * fibonacciAt(9001);
+      left += fibonacciAt(2999) * fibonacciAt(9000);
+      assert(left == fibonacciAt(12000));
+      WholeNumber twice = fibonacciAt(5000);
+      twice *= twice;
+      assert(twice == fibonacciAt(5000) * fibonacciAt(5000));
+      cout << "\tProducts match\n";
+
+      // the same with numbers large enough for the transform multiply
+      WholeNumber huge = fibonacciAt(100000) * fibonacciAt(150001);
+      huge += fibonacciAt(99999) * fibonacciAt(150000);
+      assert(huge == fibonacciAt(250000));
+      cout << "\tLarge products match\n";
+
+      // a couple of known values
+      assert(fibonacciAt(0) == WholeNumber(0));
+      assert(fibonacciAt(1) == WholeNumber(1));
+      assert(fibonacciAt(2) == WholeNumber(1));
+      assert(fibonacciAt(16) == WholeNumber(987));
+
+      // the table, and the doubling that starts from it, on either side
+      // of where 64 and 128 bits run out
+      assert(FIBONACCI_TABLE[93] == 12200160415121876738ULL);
+      assert(WholeNumber(FIBONACCI_TABLE[93]) == fibonacciSequential(93));
+      for (uint64_t n = 90; n <= 190; n++)
+         assert(fibonacciAt(n) == fibonacciSequential(n));
+      for (uint64_t n = 370; n <= 380; n++)
+         assert(fibonacciAt(n) == fibonacciSequential(n));
+
+      // both ways of writing the digits, across a chunk boundary
+      string text;
+      fibonacciAt(100).toString(text);
+      assert(text == "354,224,848,179,261,915,075");
+      fibonacciAt(100).toString(text, DIGITS_PLAIN);
+      assert(text == "354224848179261915075");
+      fibonacciAt(45).toString(text);
+      assert(text == "1,134,903,170");
+      fibonacciAt(100).toString(text, DIGITS_HEX);
+      assert(text == "1333db76a7c594bfc3");
+      WholeNumber(0).toString(text, DIGITS_PLAIN);
+      assert(text == "0");
+      WholeNumberView().toString(text, DIGITS_HEX);
+      assert(text == "0");
+      WholeNumberView().toString(text);
+      assert(text == "0");
+
+      // long enough for the splits to use the transforms; all nines and
+      // a power of ten leave the largest and smallest remainders
+      string nines(80000, '9');
+      parseWholeNumber(nines).toString(text, DIGITS_PLAIN);
+      assert(text == nines);
+      string power = "1" + string(80000, '0');
+      parseWholeNumber(power).toString(text, DIGITS_PLAIN);
+      assert(text == power);
+      cout << "\tDigits are formatted\n";
+
+      // a batch comes back in the order it was asked for, duplicates too
+      uint64_t asked[] = { 10, 50000, 0, 7, 50000, 1000, 1 };
+      vector <uint64_t> indices(asked, asked + 7);
+      vector <WholeNumber> batch = fibonacciBatch(indices);
+      assert(batch.size() == indices.size());
+      for (size_t i = 0; i < indices.size(); i++)
+         assert(batch[i] == fibonacciAt(indices[i]));
+      cout << "\tBatch matches\n";
+
+      // tasks that start and wait on tasks of their own, on fewer
+      // threads than there are tasks waiting
+      ThreadPool pool(2);
+      TaskGroup outer;
+      WholeNumber sums[4];
+      for (int i = 0; i < 4; i++)
+         pool.run(outer, [&pool, &sums, i]
+         {
+            WholeNumber parts[3];
+            TaskGroup inner;
+            for (int j = 0; j < 3; j++)
+               pool.run(inner, [&parts, i, j]
+               {
+                  parts[j] = fibonacciAt(1000 * i + j);
+               });
+            pool.wait(inner);
+            sums[i] = parts[0] + parts[1];
+            assert(sums[i] == parts[2]);
+         });
+      pool.wait(outer);
+      for (int i = 0; i < 4; i++)
+         assert(sums[i] == fibonacciAt(1000 * i + 2));
+
+      // a task that throws something other than a string still
+      // finishes, and the group reports it
+      TaskGroup failing;
+      pool.run(failing, [] { throw length_error("too long"); });
+      bool reported = false;
+      try
+      {
+         pool.wait(failing);
+      }
+      catch (const char * error)
+      {
+         reported = true;
+      }
+      assert(reported);
+      cout << "\tNested tasks finish\n";
+
+      // a checkpoint cache gives the same numbers and reuses them
+      CheckpointCache cache(1000, 1 << 20);
+      assert(cache.at(12345) == fibonacciAt(12345));
+      assert(cache.at(12999) == fibonacciAt(12999));
+      assert(cache.at(12000) == fibonacciAt(12000));
+      assert(cache.at(999) == fibonacciAt(999));
+      assert(cache.hits() == 2 && cache.misses() == 1);
+      assert(cache.at(40001) == fibonacciAt(40001));
+      assert(cache.size() == 2);
+
+      // a tight budget drops the checkpoint used longest ago
+      CheckpointCache small(1000, 30000);
+      small.at(50000);
+      small.at(60000);
+      small.at(70000);
+      assert(small.bytes() <= 30000 && small.evictions() == 1);
+      uint64_t k;
+      WholeNumber current;
+      WholeNumber next;
+      assert(!small.find(59999, k, current, next));
+      assert(small.find(70500, k, current, next) && k == 70000);
+      assert(current == fibonacciAt(70000) && next == fibonacciAt(70001));
+
+      // and from several threads at once
+      TaskGroup readers;
+      bool agree[8];
+      for (int i = 0; i < 8; i++)
+         pool.run(readers, [&cache, &agree, i]
+         {
+            uint64_t n = 12000 + 3917 * (i % 3) + i;
+            agree[i] = cache.at(n) == fibonacciAt(n);
+         });
+      pool.wait(readers);
+      for (int i = 0; i < 8; i++)
+         assert(agree[i]);
+
+      // queries go through the shared cache, so one near another
+      // starts from the checkpoint the first left behind
+      CheckpointCache & shared = CheckpointCache::shared();
+      uint64_t far = 3 * CHECKPOINT_STRIDE;
+      WholeNumber expected;
+      WholeNumber after;
+      shared.clear();
+      unsigned long hits = shared.hits();
+      fibonacciPair(far + 17, expected, after);
+      assert(fibonacciAt(far + 17) == expected);
+      assert(shared.hits() == hits);
+      assert(shared.find(far + 17, k, current, next) && k == far);
+      fibonacciPair(far + 500, expected, after);
+      assert(fibonacciAt(far + 500) == expected);
+      assert(shared.hits() == hits + 1);
+      vector <uint64_t> nearby;
+      nearby.push_back(far + 900);
+      nearby.push_back(far + 40);
+      vector <WholeNumber> nearbyResults = fibonacciBatch(nearby);
+      assert(shared.hits() == hits + 2);
+      fibonacciPair(far + 40, expected, after);
+      assert(nearbyResults[1] == expected);
+      fibonacciPair(far + 900, expected, after);
+      assert(nearbyResults[0] == expected);
+
+      // a cache of our own keeps to itself
+      shared.clear();
+      CheckpointCache own(1000, 1 << 20);
+      fibonacciPair(far + 2500, expected, after);
+      assert(own.at(far + 2500) == expected);
+      assert(own.size() == 1 && shared.size() == 0);
+      cout << "\tCheckpoints match\n";
+
+      // a table written to a file and mapped back in
+      const char * tableName = "week07.table";
+      CheckpointTable::generate(tableName, 5000, 9);
+      CheckpointTable table;
+      table.open(tableName);
+      assert(table.count() == 9 && table.stride() == 5000);
+      assert(WholeNumber(table.current(0)) == WholeNumber(0));
+      assert(WholeNumber(table.current(7)) == fibonacciAt(35000));
+      assert(WholeNumber(table.next(7)) == fibonacciAt(35001));
+      assert(table.at(12345) == fibonacciAt(12345));
+      assert(table.at(50001) == fibonacciAt(50001));
+      string fromView;
+      table.current(2).toString(fromView);
+      fibonacciAt(10000).toString(text);
+      assert(fromView == text);
+      table.close();
+
+      // one changed byte must be caught
+      {
+         fstream damage(tableName, ios::in | ios::out | ios::binary);
+         damage.seekp(200);
+         damage.put('x');
+      }
+      bool caught = false;
+      try
+      {
+         table.open(tableName);
+      }
+      catch (const char * error)
+      {
+         caught = true;
+      }
+      assert(caught && !table.isOpen());
+
+      // and so must a changed stride, which would give wrong numbers
+      CheckpointTable::generate(tableName, 5000, 9);
+      {
+         fstream damage(tableName, ios::in | ios::out | ios::binary);
+         uint64_t stride = 5001;
+         damage.seekp(offsetof(TableHeader, stride));
+         damage.write(reinterpret_cast <const char *>(&stride), sizeof(stride));
+      }
+      caught = false;
+      try
+      {
+         table.open(tableName);
+      }
+      catch (const char * error)
+      {
+         caught = true;
+      }
+      assert(caught && !table.isOpen());
+      remove(tableName);
+      cout << "\tCheckpoint table matches\n";
+
+      // a long loop that saves as it goes, stopped and picked back up
+      RunOptions run;
+      run.fileName = "week07.state";
+      run.everySteps = 500;
+      assert(fibonacciResumable(3000, run) == fibonacciAt(3000));
+      saveRunState(run.fileName, 1234, fibonacciAt(1234), fibonacciAt(1235));
+      run.resume = true;
+      assert(fibonacciResumable(4321, run) == fibonacciAt(4321));
+      WholeNumber saved;
+      WholeNumber savedNext;
+      assert(loadRunState(run.fileName, k, saved, savedNext) && k == 4321);
+      assert(saved == fibonacciAt(4321) && savedNext == fibonacciAt(4322));
+      {
+         fstream damage(run.fileName, ios::in | ios::out | ios::binary);
+         damage.seekp(-3, ios::end);
+         damage.put('x');
+      }
+      caught = false;
+      try
+      {
+         loadRunState(run.fileName, k, saved, savedNext);
+      }
+      catch (const char * error)
+      {
+         caught = true;
+      }
+      assert(caught);
+
+      // a damaged index would pick up from the wrong place, so the
+      // header is checked too
+      saveRunState(run.fileName, 4321, saved, savedNext);
+      {
+         fstream damage(run.fileName, ios::in | ios::out | ios::binary);
+         damage.seekp(offsetof(StateHeader, index));
+         damage.put('x');
+      }
+      caught = false;
+      try
+      {
+         loadRunState(run.fileName, k, saved, savedNext);
+      }
+      catch (const char * error)
+      {
+         caught = true;
+      }
+      assert(caught);
+      remove(run.fileName);
+      assert(!loadRunState(run.fileName, k, saved, savedNext));
+      cout << "\tResumed run matches\n";
+
+      // F(n) mod m, against the numbers that fit in 64 bits, for odd,
+      // even and full 64-bit moduli
+      {
+         const uint64_t moduli[] = { 1, 2, 10, 1000, 1000000007ULL,
+                                     1ULL << 63, 0xffffffffffffffffULL };
+         vector <uint64_t> batchIndices;
+         vector <uint64_t> batchModuli;
+         uint64_t small = 0;       // F(i)
+         uint64_t smallNext = 1;   // F(i + 1)
+         for (uint64_t i = 0; i <= 93; i++)
+         {
+            for (size_t j = 0; j < sizeof(moduli) / sizeof(moduli[0]); j++)
+            {
+               assert(fibonacciMod(i, moduli[j]) == small % moduli[j]);
+               batchIndices.push_back(i);
+               batchModuli.push_back(moduli[j]);
+            }
+            smallNext += small;
+            small = smallNext - small;
+         }
+         vector <uint64_t> remainders = fibonacciModBatch(batchIndices, batchModuli);
+         for (size_t i = 0; i < remainders.size(); i++)
+            assert(remainders[i] == fibonacciMod(batchIndices[i], batchModuli[i]));
+      }
+      assert(pisanoMultiple(10) % 60 == 0);
+      assert(pisanoMultiple(1000) % 1500 == 0);
+
+      // a huge index: F(40000) is short enough to walk, and F(60000)
+      // is cut down by the Pisano period first
+      assert(fibonacciMod(fibonacciAt(40000), 1000000007) == 631880955);
+      assert(fibonacciMod(fibonacciAt(60000), 1000000007) == 178816593);
+      assert(fibonacciMod(fibonacciAt(60000), 1000) == 0);
+      assert(fibonacciMod(fibonacciAt(60000), 0xffffffffffffffc5ULL) ==
+             2059776276602895419ULL);
+      cout << "\tFibonacci mod m matches\n";
+
+      // long sums go through the vector kernel: carries that run the
+      // whole length, a number added to itself, and a ragged tail
+      {
+         vector <Limb> allOnes(45, 0xffffffff);
+         WholeNumber ones(WholeNumberView(&allOnes[0], allOnes.size()));
+         WholeNumber doubled = ones;
+         doubled += doubled;
+         doubled.toString(text, DIGITS_HEX);
+         assert(text == "1" + string(45 * 8 - 1, 'f') + "e");
+         doubled -= ones;
+         assert(doubled == ones);
+
+         WholeNumber big = fibonacciAt(100003);
+         WholeNumber sum = big + ones;
+         sum -= ones;
+         assert(sum == big);
+         sum = ones + big;
+         sum -= big;
+         assert(sum == ones);
+
+         // big enough to be split across the threads, with a carry
+         // that runs from the first chunk through all the others
+         allOnes.assign(3 << 20, 0xffffffff);
+         allOnes[0] = 1;
+         WholeNumber huge(WholeNumberView(&allOnes[0], allOnes.size()));
+         allOnes.assign(allOnes.size(), 0);
+         allOnes[0] = 0xffffffff;
+         allOnes.back() = 1;
+         WholeNumber hugeTerm(WholeNumberView(&allOnes[0], allOnes.size()));
+         sum = huge + hugeTerm;
+         assert(sum.size() == allOnes.size() + 1);
+         assert(sum.limbs()[0] == 0 && sum.limbs()[1 << 20] == 0);
+         assert(sum.limbs()[allOnes.size() - 1] == 1);
+         assert(sum.limbs()[allOnes.size()] == 1);
+         sum -= hugeTerm;
+         assert(sum == huge);
+      }
+      cout << "\tLong additions match\n";
+
+      // small numbers take the short way, and must still grow past it
+      {
+         const uint64_t most = 0xffffffffffffffffULL;
+         WholeNumber x(most);
+         WholeNumber y(most);
+         x += y;
+         assert(x.size() == 3);
+         x.toString(text, DIGITS_HEX);
+         assert(text == "1fffffffffffffffe");
+         x -= y;
+         assert(x == y && x.size() == 2);
+
+         x *= y;
+         x.toString(text, DIGITS_HEX);
+         assert(text == "fffffffffffffffe0000000000000001");
+         WholeNumber z = x * x;
+         assert(z.size() == 8);
+         assert(z == WholeNumber(most) * WholeNumber(most) *
+                     WholeNumber(most) * WholeNumber(most));
+         z.square();
+         assert(z.size() == 16);
+
+         // swaps and moves between numbers kept in place and on the heap
+         WholeNumber small(12345);
+         swap(small, z);
+         assert(z == WholeNumber(12345) && small.size() == 16);
+         swap(small, z);
+         assert(small == WholeNumber(12345) && z.size() == 16);
+         WholeNumber moved(std::move(z));
+         assert(moved.size() == 16);
+         z = std::move(small);
+         assert(z == WholeNumber(12345));
+
+         bool thrown = false;
+         try
+         {
+            WholeNumber(3) - WholeNumber(5);
+         }
+         catch (const char *)
+         {
+            thrown = true;
+         }
+         assert(thrown);
+      }
+      cout << "\tSmall numbers match\n";
+
+      // other recurrences, far away and step by step
+      {
+         typedef LinearRecurrence <WholeNumber> Recurrence;
+         Recurrence fib = Recurrence::fibonacci();
+         assert(fib.at(0) == WholeNumber(0) && fib.at(93) == fibonacciAt(93));
+         assert(fib.at(100003) == fibonacciAt(100003));
+
+         // L(n) = F(n - 1) + F(n + 1)
+         Recurrence lucas = Recurrence::lucas();
+         assert(lucas.at(0) == WholeNumber(2) && lucas.at(10) == WholeNumber(123));
+         assert(lucas.at(5000) == fibonacciAt(4999) + fibonacciAt(5001));
+
+         assert(Recurrence::pell().at(10) == WholeNumber(2378));
+         Recurrence tribonacci = Recurrence::kBonacci(3);
+         assert(tribonacci.at(10) == WholeNumber(81));
+         assert(tribonacci.at(37) == WholeNumber(1132436852));
+
+         // Padovan: a(n) = a(n - 2) + a(n - 3)
+         vector <Limb> coefficients;
+         coefficients.push_back(0);
+         coefficients.push_back(1);
+         coefficients.push_back(1);
+         Recurrence padovan(coefficients, vector <WholeNumber>(3, WholeNumber(1)));
+         assert(padovan.at(20) == WholeNumber(200));
+
+         // a walk must meet the far-away terms, from any starting point,
+         // and a recurrence modulo 2^64 must agree with the low limbs
+         coefficients.assign(1, 3);
+         coefficients.push_back(0);
+         coefficients.push_back(0);
+         coefficients.push_back(5);
+         vector <WholeNumber> initial;
+         vector <uint64_t> initialLow;
+         for (int i = 0; i < 4; i++)
+         {
+            initial.push_back(WholeNumber(i * 7 + 1));
+            initialLow.push_back(i * 7 + 1);
+         }
+         Recurrence odd(coefficients, initial);
+         LinearRecurrence <uint64_t> oddLow(coefficients, initialLow);
+         uint64_t starts[] = { 0, 2, 3, 4, 1000 };
+         for (int s = 0; s < 5; s++)
+         {
+            int visited = 0;
+            odd.forEach(starts[s], starts[s] + 40,
+               [&](uint64_t n, const WholeNumber & term)
+               {
+                  assert(term == odd.at(n));
+                  uint64_t low = term.limbs()[0];
+                  if (term.size() > 1)
+                     low |= (uint64_t)term.limbs()[1] << 32;
+                  assert(low == oddLow.at(n));
+                  visited++;
+               });
+            assert(visited == 41);
+         }
+      }
+      cout << "\tRecurrences match\n";
+
+      // the first and last digits, against all of them and against
+      // answers worked out elsewhere for F(10^15)
+      uint64_t digitIndices[] = { 1, 10, 93, 94, 1090, 4095, 4096, 9838, 19999 };
+      for (int i = 0; i < 9; i++)
+      {
+         uint64_t n = digitIndices[i];
+         fibonacciAt(n).toString(text, DIGITS_PLAIN);
+         assert(fibonacciDigitCount(n) == text.size());
+         assert(fibonacciLeadingDigits(n, 100) == text.substr(0, 100));
+         assert(fibonacciLeadingDigits(n, 3) == text.substr(0, 3));
+         size_t tail = text.size() < 27 ? text.size() : 27;
+         assert(fibonacciTrailingDigits(n, 27) == text.substr(text.size() - tail));
+      }
+      assert(fibonacciDigitCount(1000000000000000ULL) == 208987640249979ULL);
+      assert(fibonacciLeadingDigits(1000000000000000ULL, 20) ==
+             "24226142638072665895");
+      assert(fibonacciTrailingDigits(1000000000000000ULL, 27) ==
+             "041844897865788299560546875");
+      cout << "\tLeading and trailing digits match\n";
+
+      // reading numbers back in, and finding where they come from
+      {
+         WholeNumber big = fibonacciAt(100003);
+         big.toString(text, DIGITS_COMMAS);
+         assert(parseWholeNumber(text) == big);
+         big.toString(text, DIGITS_PLAIN);
+         assert(parseWholeNumber(text) == big);
+         assert(parseWholeNumber("0") == WholeNumber(0));
+         assert(parseWholeNumber("000123") == WholeNumber(123));
+         assert(parseWholeNumber("1,234,567") == WholeNumber(1234567));
+
+         // commas only between groups of three, after one to three
+         const char * bad[] = { "", "12a", ",12", "12,", "-3", "1,,2",
+                                "12,34", "1,", "1234,567", "1,2345",
+                                "1,234,56" };
+         for (int i = 0; i < 11; i++)
+         {
+            bool thrown = false;
+            try
+            {
+               parseWholeNumber(bad[i]);
+            }
+            catch (const char *)
+            {
+               thrown = true;
+            }
+            assert(thrown);
+         }
+
+         uint64_t n;
+         assert(fibonacciIndexOf(WholeNumber(0), n) && n == 0);
+         assert(fibonacciIndexOf(WholeNumber(1), n) && n == 1);
+         assert(!fibonacciIndexOf(WholeNumber(4), n));
+         uint64_t indices[] = { 3, 93, 94, 95, 1000, 100003 };
+         for (int i = 0; i < 6; i++)
+         {
+            WholeNumber f = fibonacciAt(indices[i]);
+            assert(fibonacciIndexOf(f, n) && n == indices[i]);
+            f += WholeNumber(2);
+            assert(!fibonacciIndexOf(f, n));
+         }
+         assert(!fibonacciIndexOf(fibonacciAt(5000) * WholeNumber(3), n));
+      }
+      cout << "\tIndices of Fibonacci numbers match\n";
+   }
+   catch (const char * error)
+   {
+      cout << error << endl;
+   }
+#endif // TEST5
+}
+
+/*******************************************
+ * TEST UNROLLED
+ * The same inserts and removes on a List and on
+ * an UnrolledList must leave the same contents,
+ * read forwards and backwards
+ *******************************************/
+void testUnrolled()
+{
+#ifdef TEST6
+   try
+   {
+      // a small chunk so that nodes split and merge often
+      List <int> l;
+      UnrolledList <int, 4> u;
+      srand(235);
+
+      for (int step = 0; step < 5000; step++)
+      {
+         // pick a spot and walk both lists to it
+         int index = l.empty() ? 0 : rand() % (l.size() + 1);
+         ListIterator <int> it = l.begin();
+         UnrolledList <int, 4>::iterator uit = u.begin();
+         for (int i = 0; i < index; i++, ++it, ++uit)
+            ;
+
+         // grow more often than shrink, so the lists get long
+         if (rand() % 3 || index == l.size())
+         {
+            l.insert(it, step);
+            u.insert(uit, step);
+         }
+         else
+         {
+            l.remove(it);
+            u.remove(uit);
+            assert(it == l.end() ? uit == u.end() : *it == *uit);
+         }
+      }
+      assert(l.size() == u.size());
+      cout << "\tSizes match: " << u.size() << " in " << u.nodes()
+           << " nodes\n";
+
+      ListIterator <int> it = l.begin();
+      UnrolledList <int, 4>::iterator uit = u.begin();
+      for (; it != l.end(); ++it, ++uit)
+         assert(*it == *uit);
+      assert(uit == u.end());
+
+      it = l.rbegin();
+      uit = u.rbegin();
+      for (; it != l.rend(); --it, --uit)
+         assert(*it == *uit);
+      assert(uit == u.rend());
+      cout << "\tContents match forwards and backwards\n";
+
+      // copies, moves and clears
+      UnrolledList <int, 4> copy(u);
+      assert(copy.size() == u.size() && copy.front() == u.front() &&
+             copy.back() == u.back());
+      UnrolledList <int, 4> moved(std::move(copy));
+      assert(copy.empty() && moved.size() == u.size());
+      moved.clear();
+      assert(moved.empty() && moved.nodes() == 0);
+
+      // the pool's counts travel with the nodes
+      unsigned long requests = l.allocator().requests();
+      List <int> other;
+      other.push_back(1);
+      other.swap(l);
+      assert(other.allocator().requests() == requests);
+      assert(l.allocator().requests() == 1 && l.size() == 1);
+      List <int> taken(std::move(other));
+      assert(taken.allocator().requests() == requests);
+      cout << "\tCopy, move and clear work\n";
+   }
+   catch (const char * error)
+   {
+      cout << error << endl;
+   }
+#endif // TEST6
+}
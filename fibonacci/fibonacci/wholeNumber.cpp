@@ -0,0 +1,1938 @@
+/***********************************************************************
+ * Implementation:
+ *    WholeNumber
+ * Summary:
+ *    The heavy lifting behind WholeNumber: the multiplication kernels
+ *    and the conversion to decimal. These work on plain arrays of
+ *    32-bit limbs, least significant first.
+ * Author:
+ *    Matthew Burr, Shayla Nelson, Bryan Lopez, Kimberly Stowe
+ ************************************************************************/
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "threadPool.h"
+#include "wholeNumber.h"
+
+// the vector add kernels need GCC's target attributes and an x86
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define VECTOR_ADD_KERNELS
+#endif
+using namespace std;
+
+// below these many limbs the grade-school method beats Karatsuba.
+// Both were found by timing F(n) for n between 10^4 and 10^6
+#define KARATSUBA_THRESHOLD        32
+#define KARATSUBA_SQUARE_THRESHOLD 48
+
+// from these many limbs in the smaller factor on, the number-theoretic
+// transform beats Karatsuba
+#define NTT_THRESHOLD 5000
+
+// numbers up to these many limbs go to decimal by repeated division
+// by 10^9; larger ones are split in half by a power of 10^9 first
+#define DECIMAL_THRESHOLD 40
+
+// from these many limbs on, the powers of 10^9 that split numbers for
+// decimal are kept transformed, and the splits use the NTT
+#define DECIMAL_NTT_THRESHOLD 1000
+
+// sums of at least these many limbs are split across the shared pool,
+// with no fewer than PARALLEL_ADD_CHUNK limbs for each thread. Below
+// that, starting the tasks costs more than the threads save
+#define PARALLEL_ADD_THRESHOLD (1 << 20)
+#define PARALLEL_ADD_CHUNK     (1 << 18)
+
+// products whose smaller factor has at least these many limbs work out
+// their Karatsuba pieces as tasks on the shared pool
+#define PARALLEL_KARATSUBA_THRESHOLD 1024
+
+// transforms at least this long are split across the shared pool, and
+// every task gets at least PARALLEL_GRAIN butterflies or limbs
+#define PARALLEL_NTT_THRESHOLD (1 << 14)
+#define PARALLEL_GRAIN         (1 << 12)
+
+// root tables up to this long are kept from one product to the next;
+// longer ones are built for their product and thrown away
+#define ROOT_CACHE_SIZE (1 << 20)
+
+// the reciprocals of the powers of 10^9 used for decimal carry this
+// many limbs past the point where the quotient needs them
+#define RECIPROCAL_GUARD 2
+
+/************************************************
+ * ADD ONTO SCALAR
+ * x += y over n limbs, one limb at a time,
+ * returning the carry out of the top
+ ***********************************************/
+static Limb addOntoScalar(Limb * x, const Limb * y, size_t n)
+{
+   uint64_t carry = 0;
+   for (size_t i = 0; i < n; i++)
+   {
+      carry += (uint64_t)x[i] + y[i];
+      x[i] = (Limb)carry;
+      carry >>= 32;
+   }
+   return (Limb)carry;
+}
+
+#ifdef VECTOR_ADD_KERNELS
+/************************************************
+ * ADD ONTO AVX2
+ * Eight limbs at a time. Each lane is added on
+ * its own; a lane whose sum wrapped generates a
+ * carry, and a lane that came to all ones passes
+ * on any carry it gets. With those as bit masks,
+ *    ((generate << 1) + carry in + propagate)
+ * runs every carry through the block at once, and
+ * xor with propagate leaves the lanes that get
+ * one more. A carry chain of any length costs the
+ * same as none, and a block with no carries at
+ * all skips that work.
+ ***********************************************/
+__attribute__((target("avx2")))
+static Limb addOntoAvx2(Limb * x, const Limb * y, size_t n)
+{
+   const __m256i ones = _mm256_set1_epi32(-1);
+   const __m256i lanes = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+
+   unsigned carry = 0;
+   size_t i = 0;
+   for (; i + 8 <= n; i += 8)
+   {
+      __m256i a = _mm256_loadu_si256(reinterpret_cast <const __m256i *>(x + i));
+      __m256i b = _mm256_loadu_si256(reinterpret_cast <const __m256i *>(y + i));
+      __m256i sum = _mm256_add_epi32(a, b);
+
+      // sum < a exactly when max(sum, a) is not sum
+      unsigned generate = ~_mm256_movemask_ps(_mm256_castsi256_ps(
+         _mm256_cmpeq_epi32(_mm256_max_epu32(sum, a), sum))) & 0xff;
+      unsigned incoming = (generate << 1) + carry;
+      if (incoming)
+      {
+         unsigned propagate = _mm256_movemask_ps(_mm256_castsi256_ps(
+            _mm256_cmpeq_epi32(sum, ones)));
+         unsigned rippled = incoming + propagate;
+         unsigned bump = (rippled ^ propagate) & 0xff;
+         carry = rippled >> 8;
+
+         // subtracting -1 from the bumped lanes adds one to them
+         __m256i mask = _mm256_and_si256(_mm256_set1_epi32(bump), lanes);
+         sum = _mm256_sub_epi32(sum, _mm256_cmpeq_epi32(mask, lanes));
+      }
+      _mm256_storeu_si256(reinterpret_cast <__m256i *>(x + i), sum);
+   }
+
+   uint64_t rest = carry;
+   for (; i < n; i++)
+   {
+      rest += (uint64_t)x[i] + y[i];
+      x[i] = (Limb)rest;
+      rest >>= 32;
+   }
+   return (Limb)rest;
+}
+
+/************************************************
+ * ADD ONTO AVX-512
+ * The same as AVX2 with sixteen limbs at a time.
+ * The compares give masks directly, and the masked
+ * subtract bumps the lanes without a lookup.
+ ***********************************************/
+__attribute__((target("avx512f")))
+static Limb addOntoAvx512(Limb * x, const Limb * y, size_t n)
+{
+   const __m512i ones = _mm512_set1_epi32(-1);
+
+   unsigned carry = 0;
+   size_t i = 0;
+   for (; i + 16 <= n; i += 16)
+   {
+      __m512i a = _mm512_loadu_si512(x + i);
+      __m512i b = _mm512_loadu_si512(y + i);
+      __m512i sum = _mm512_add_epi32(a, b);
+
+      unsigned generate = _mm512_cmplt_epu32_mask(sum, a);
+      unsigned incoming = (generate << 1) + carry;
+      if (incoming)
+      {
+         unsigned propagate = _mm512_cmpeq_epi32_mask(sum, ones);
+         unsigned rippled = incoming + propagate;
+         carry = rippled >> 16;
+         sum = _mm512_mask_sub_epi32(sum, (__mmask16)(rippled ^ propagate),
+                                     sum, ones);
+      }
+      _mm512_storeu_si512(x + i, sum);
+   }
+
+   uint64_t rest = carry;
+   for (; i < n; i++)
+   {
+      rest += (uint64_t)x[i] + y[i];
+      x[i] = (Limb)rest;
+      rest >>= 32;
+   }
+   return (Limb)rest;
+}
+#endif // VECTOR_ADD_KERNELS
+
+typedef Limb (*AddKernel)(Limb *, const Limb *, size_t);
+
+/************************************************
+ * CHOOSE ADD KERNEL
+ * The fastest kernel this processor has
+ ***********************************************/
+static AddKernel chooseAddKernel()
+{
+#ifdef VECTOR_ADD_KERNELS
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx512f"))
+      return addOntoAvx512;
+   if (__builtin_cpu_supports("avx2"))
+      return addOntoAvx2;
+#endif
+   return addOntoScalar;
+}
+
+/************************************************
+ * ADD ONTO PARALLEL
+ * Splits x += y into a chunk per thread. Each
+ * chunk is added as if no carry came into it,
+ * noting whether it carries out (generates) and
+ * whether it came to all ones (propagates). The
+ * carry into each chunk then follows from those
+ * flags alone, and the chunks that get one are
+ * fixed up at the same time. A fix-up stops at
+ * the first limb that does not wrap, which is
+ * nearly always the first.
+ ***********************************************/
+static Limb addOntoParallel(Limb * x, const Limb * y, size_t n,
+                            AddKernel kernel, ThreadPool & pool)
+{
+   size_t chunks = min((size_t)pool.size(), n / PARALLEL_ADD_CHUNK);
+   size_t length = (n + chunks - 1) / chunks;
+
+   vector <char> generate(chunks);
+   vector <char> propagate(chunks);
+   TaskGroup group;
+   for (size_t c = 0; c < chunks; c++)
+   {
+      Limb * first = x + c * length;
+      size_t size = min(length, n - c * length);
+      const Limb * term = y + c * length;
+      pool.run(group, [=, &generate, &propagate]
+      {
+         generate[c] = (char)kernel(first, term, size);
+         size_t i = 0;
+         while (i < size && first[i] == 0xffffffff)
+            i++;
+         propagate[c] = i == size;
+      });
+   }
+   pool.wait(group);
+
+   // the carry into each chunk, from the flags of the ones below it
+   vector <char> incoming(chunks);
+   char carry = 0;
+   for (size_t c = 0; c < chunks; c++)
+   {
+      incoming[c] = carry;
+      carry = generate[c] | (propagate[c] & carry);
+   }
+
+   for (size_t c = 0; c < chunks; c++)
+   {
+      if (!incoming[c])
+         continue;
+      Limb * first = x + c * length;
+      size_t size = min(length, n - c * length);
+      pool.run(group, [=]
+      {
+         for (size_t i = 0; i < size && ++first[i] == 0; i++)
+            ;
+      });
+   }
+   pool.wait(group);
+
+   return (Limb)carry;
+}
+
+/************************************************
+ * ADD LIMBS ONTO
+ * x += y over n limbs with the fastest kernel,
+ * spread over the shared pool when n is huge
+ ***********************************************/
+Limb addLimbsOnto(Limb * x, const Limb * y, size_t n)
+{
+   static const AddKernel kernel = chooseAddKernel();
+
+   if (n >= PARALLEL_ADD_THRESHOLD)
+   {
+      ThreadPool & pool = ThreadPool::shared();
+      if (pool.size() > 1)
+         return addOntoParallel(x, y, n, kernel, pool);
+   }
+   return kernel(x, y, n);
+}
+
+/************************************************
+ * PARALLEL POOL
+ * The shared pool if size is at least threshold
+ * and the pool has more than one thread, or NULL
+ * to say the work should stay on this thread
+ ***********************************************/
+static ThreadPool * parallelPool(size_t size, size_t threshold)
+{
+   if (size < threshold)
+      return NULL;
+   ThreadPool & pool = ThreadPool::shared();
+   return pool.size() > 1 ? &pool : NULL;
+}
+
+/************************************************
+ * SPAWN
+ * Runs work as part of group on the pool, or right
+ * here when there is no pool
+ ***********************************************/
+template <class Work>
+static void spawn(ThreadPool * pool, TaskGroup & group, const Work & work)
+{
+   if (pool)
+      pool->run(group, work);
+   else
+      work();
+}
+
+/************************************************
+ * FOR CHUNKS
+ * Calls body(begin, end) over [0, count) in a few
+ * pieces per thread of at least PARALLEL_GRAIN,
+ * or all at once when that leaves only one
+ ***********************************************/
+template <class Body>
+static void forChunks(size_t count, const Body & body)
+{
+   ThreadPool * pool = parallelPool(count, 2 * PARALLEL_GRAIN);
+   size_t chunks = pool ? min((size_t)pool->size() * 4, count / PARALLEL_GRAIN) : 1;
+   if (chunks < 2)
+   {
+      body(0, count);
+      return;
+   }
+
+   size_t length = (count + chunks - 1) / chunks;
+   TaskGroup group;
+   for (size_t begin = length; begin < count; begin += length)
+   {
+      size_t end = min(count, begin + length);
+      pool->run(group, [&body, begin, end] { body(begin, end); });
+   }
+   body(0, length);
+   pool->wait(group);
+}
+
+/************************************************
+ * ADD LIMBS
+ * sum = a + b, where sum has room for
+ * max(na, nb) + 1 limbs
+ ***********************************************/
+static void addLimbs(const Limb * a, size_t na, const Limb * b, size_t nb,
+                     Limb * sum)
+{
+   if (na < nb)
+   {
+      swap(a, b);
+      swap(na, nb);
+   }
+
+   uint64_t carry = 0;
+   size_t i = 0;
+   for (; i < nb; i++)
+   {
+      carry += (uint64_t)a[i] + b[i];
+      sum[i] = (Limb)carry;
+      carry >>= 32;
+   }
+   for (; i < na; i++)
+   {
+      carry += a[i];
+      sum[i] = (Limb)carry;
+      carry >>= 32;
+   }
+   sum[na] = (Limb)carry;
+}
+
+/************************************************
+ * ADD INTO
+ * result += term, where result is long enough
+ * to hold the answer
+ ***********************************************/
+static void addInto(Limb * result, size_t nResult,
+                    const Limb * term, size_t nTerm)
+{
+   uint64_t carry = addLimbsOnto(result, term, nTerm);
+   size_t i = nTerm;
+   for (; carry && i < nResult; i++)
+   {
+      carry += result[i];
+      result[i] = (Limb)carry;
+      carry >>= 32;
+   }
+   assert(carry == 0);
+}
+
+/************************************************
+ * SUBTRACT FROM
+ * result -= term, where result is at least as
+ * large as term
+ ***********************************************/
+static void subtractFrom(Limb * result, size_t nResult,
+                         const Limb * term, size_t nTerm)
+{
+   Limb borrow = 0;
+   size_t i = 0;
+   for (; i < nTerm; i++)
+   {
+      uint64_t difference = (uint64_t)result[i] - term[i] - borrow;
+      result[i] = (Limb)difference;
+      borrow = (Limb)(difference >> 63);
+   }
+   for (; borrow && i < nResult; i++)
+   {
+      borrow = result[i] == 0;
+      result[i]--;
+   }
+   assert(borrow == 0);
+}
+
+/************************************************
+ * MULTIPLY SCHOOLBOOK
+ * The grade-school method, one row at a time.
+ * a[i] b[j] + product[i + j] + carry always fits
+ * in 64 bits.
+ ***********************************************/
+static void multiplySchoolbook(const Limb * a, size_t na,
+                               const Limb * b, size_t nb, Limb * product)
+{
+   fill(product, product + na + nb, 0);
+   for (size_t i = 0; i < na; i++)
+   {
+      uint64_t digit = a[i];
+      if (digit == 0)
+         continue;
+
+      Limb * row = product + i;
+      uint64_t carry = 0;
+      for (size_t j = 0; j < nb; j++)
+      {
+         carry += digit * b[j] + row[j];
+         row[j] = (Limb)carry;
+         carry >>= 32;
+      }
+      row[nb] = (Limb)carry;
+   }
+}
+
+/************************************************
+ * SQUARE SCHOOLBOOK
+ * As above, but each cross product a[i] a[j] is
+ * found once. The sum of them is doubled with a
+ * shift, then the squares a[i]^2 are added in.
+ ***********************************************/
+static void squareSchoolbook(const Limb * a, size_t na, Limb * product)
+{
+   fill(product, product + 2 * na, 0);
+   for (size_t i = 0; i + 1 < na; i++)
+   {
+      uint64_t digit = a[i];
+      if (digit == 0)
+         continue;
+
+      Limb * row = product + i;
+      uint64_t carry = 0;
+      for (size_t j = i + 1; j < na; j++)
+      {
+         carry += digit * a[j] + row[j];
+         row[j] = (Limb)carry;
+         carry >>= 32;
+      }
+      row[na] = (Limb)carry;
+   }
+
+   // double the cross products
+   Limb top = 0;
+   for (size_t i = 0; i < 2 * na; i++)
+   {
+      Limb limb = product[i];
+      product[i] = (limb << 1) | top;
+      top = limb >> 31;
+   }
+
+   // and add the squares along the diagonal
+   uint64_t carry = 0;
+   for (size_t i = 0; i < na; i++)
+   {
+      uint64_t square = (uint64_t)a[i] * a[i];
+      carry += (uint64_t)product[2 * i] + (Limb)square;
+      product[2 * i] = (Limb)carry;
+      carry >>= 32;
+      carry += (uint64_t)product[2 * i + 1] + (square >> 32);
+      product[2 * i + 1] = (Limb)carry;
+      carry >>= 32;
+   }
+   assert(carry == 0);
+}
+
+/************************************************
+ * MONTGOMERY
+ * Arithmetic modulo an odd prime p < 2^62 in
+ * Montgomery form, where x is kept as x R mod p
+ * with R = 2^64. This turns the remainder in every
+ * product into two multiplies and a shift.
+ ***********************************************/
+struct Montgomery
+{
+   uint64_t p;       // the prime
+   uint64_t pNeg;    // -p^-1 mod 2^64
+   uint64_t r2;      // R^2 mod p
+
+   Montgomery(uint64_t prime) : p(prime)
+   {
+      // Newton's method doubles the correct bits of p^-1 every step
+      uint64_t inverse = prime;
+      for (int i = 0; i < 6; i++)
+         inverse *= 2 - prime * inverse;
+      pNeg = 0 - inverse;
+
+      unsigned __int128 r = ((unsigned __int128)1 << 64) % prime;
+      r2 = (uint64_t)(r * r % prime);
+   }
+
+   // t R^-1 mod p, for t < p 2^64
+   uint64_t reduce(unsigned __int128 t) const
+   {
+      uint64_t m = (uint64_t)t * pNeg;
+      uint64_t u = (uint64_t)((t + (unsigned __int128)m * p) >> 64);
+      return u >= p ? u - p : u;
+   }
+
+   uint64_t multiply(uint64_t a, uint64_t b) const
+   {
+      return reduce((unsigned __int128)a * b);
+   }
+
+   uint64_t add(uint64_t a, uint64_t b) const
+   {
+      uint64_t sum = a + b;
+      return sum >= p ? sum - p : sum;
+   }
+
+   uint64_t subtract(uint64_t a, uint64_t b) const
+   {
+      return a >= b ? a - b : a + p - b;
+   }
+
+   uint64_t toForm(uint64_t a) const   { return multiply(a, r2); }
+   uint64_t fromForm(uint64_t a) const { return reduce(a);       }
+
+   // base^exponent, both in Montgomery form
+   uint64_t power(uint64_t base, uint64_t exponent) const
+   {
+      uint64_t result = toForm(1);
+      for (; exponent; exponent >>= 1)
+      {
+         if (exponent & 1)
+            result = multiply(result, base);
+         base = multiply(base, base);
+      }
+      return result;
+   }
+};
+
+/************************************************
+ * The three NTT primes. Each is k 2^40 + 1, so
+ * transforms can be up to 2^40 long, and each comes
+ * with a quadratic non-residue whose powers give the
+ * roots of unity.
+ ***********************************************/
+static const int NUM_PRIMES = 3;
+static const uint64_t NTT_PRIMES[NUM_PRIMES] =
+{
+   4611615649683210241ULL,   // 4194240 2^40 + 1
+   4611613450659954689ULL,   // 4194238 2^40 + 1
+   4611549678985543681ULL    // 4194180 2^40 + 1
+};
+static const uint64_t NTT_NONRESIDUES[NUM_PRIMES] = { 7, 3, 11 };
+
+/************************************************
+ * ROOT TABLE
+ * roots[half + j] = w^j, where w is a primitive
+ * (2 half)th root of unity, for every half that is
+ * a power of two below size
+ ***********************************************/
+static void rootTable(const Montgomery & field, uint64_t nonResidue,
+                      size_t size, bool inverse, vector <uint64_t> & roots)
+{
+   roots.assign(size, 0);
+
+   // a primitive size-th root of unity
+   uint64_t root = field.power(field.toForm(nonResidue),
+                               (field.p - 1) / size);
+   if (inverse)
+      root = field.power(root, size - 1);
+
+   // each chunk starts from root^begin and multiplies its way up
+   for (size_t half = size / 2; half >= 1; half /= 2)
+   {
+      forChunks(half, [&, field, root](size_t begin, size_t end)
+      {
+         uint64_t power = field.power(root, begin);
+         for (size_t j = begin; j < end; j++)
+         {
+            roots[half + j] = power;
+            power = field.multiply(power, root);
+         }
+      });
+      root = field.multiply(root, root);
+   }
+}
+
+/************************************************
+ * TRANSFORM FORWARD
+ * Decimation in frequency: natural order in,
+ * bit-reversed order out. After the first stage
+ * the two halves are transforms of their own, so
+ * a long one does its first stage in chunks and
+ * then its halves side by side.
+ ***********************************************/
+static void transformForward(const Montgomery & field, const uint64_t * roots,
+                             uint64_t * data, size_t size)
+{
+   if (size >= PARALLEL_NTT_THRESHOLD && parallelPool(size, PARALLEL_NTT_THRESHOLD))
+   {
+      size_t half = size / 2;
+      forChunks(half, [&, field](size_t begin, size_t end)
+      {
+         for (size_t j = begin; j < end; j++)
+         {
+            uint64_t u = data[j];
+            uint64_t v = data[half + j];
+            data[j]        = field.add(u, v);
+            data[half + j] = field.multiply(field.subtract(u, v), roots[half + j]);
+         }
+      });
+
+      ThreadPool & pool = ThreadPool::shared();
+      TaskGroup group;
+      pool.run(group, [&] { transformForward(field, roots, data, half); });
+      transformForward(field, roots, data + half, half);
+      pool.wait(group);
+      return;
+   }
+
+   // a copy of the field that no store to data can touch, so its
+   // members stay in registers; the lambdas above copy it for the same
+   // reason
+   const Montgomery local = field;
+   for (size_t half = size / 2; half >= 1; half /= 2)
+      for (size_t start = 0; start < size; start += 2 * half)
+      {
+         uint64_t * low  = data + start;
+         uint64_t * high = data + start + half;
+         const uint64_t * root = roots + half;
+         for (size_t j = 0; j < half; j++)
+         {
+            uint64_t u = low[j];
+            uint64_t v = high[j];
+            low[j]  = local.add(u, v);
+            high[j] = local.multiply(local.subtract(u, v), root[j]);
+         }
+      }
+}
+
+/************************************************
+ * TRANSFORM INVERSE
+ * Decimation in time: bit-reversed order in,
+ * natural order out. The caller scales by 1/size.
+ * The mirror image of the forward transform: the
+ * halves first, side by side, then the last stage.
+ ***********************************************/
+static void transformInverse(const Montgomery & field, const uint64_t * roots,
+                             uint64_t * data, size_t size)
+{
+   if (size >= PARALLEL_NTT_THRESHOLD && parallelPool(size, PARALLEL_NTT_THRESHOLD))
+   {
+      size_t half = size / 2;
+      ThreadPool & pool = ThreadPool::shared();
+      TaskGroup group;
+      pool.run(group, [&] { transformInverse(field, roots, data, half); });
+      transformInverse(field, roots, data + half, half);
+      pool.wait(group);
+
+      forChunks(half, [&, field](size_t begin, size_t end)
+      {
+         for (size_t j = begin; j < end; j++)
+         {
+            uint64_t u = data[j];
+            uint64_t v = field.multiply(data[half + j], roots[half + j]);
+            data[j]        = field.add(u, v);
+            data[half + j] = field.subtract(u, v);
+         }
+      });
+      return;
+   }
+
+   const Montgomery local = field;
+   for (size_t half = 1; half < size; half *= 2)
+      for (size_t start = 0; start < size; start += 2 * half)
+      {
+         uint64_t * low  = data + start;
+         uint64_t * high = data + start + half;
+         const uint64_t * root = roots + half;
+         for (size_t j = 0; j < half; j++)
+         {
+            uint64_t u = low[j];
+            uint64_t v = local.multiply(high[j], root[j]);
+            low[j]  = local.add(u, v);
+            high[j] = local.subtract(u, v);
+         }
+      }
+}
+
+/************************************************
+ * ROOTS
+ * A root table at least size long. No entry
+ * depends on the table's length, so the longest
+ * one built so far serves every shorter transform
+ * and is only replaced by a longer one. It is
+ * built outside the lock, since building a long
+ * one waits on the pool.
+ ***********************************************/
+static shared_ptr <const vector <uint64_t> > roots(int prime, size_t size,
+                                                   bool inverse)
+{
+   static mutex lock;
+   static shared_ptr <const vector <uint64_t> > cache[NUM_PRIMES][2];
+
+   bool keep = size <= ROOT_CACHE_SIZE;
+   if (keep)
+   {
+      lock_guard <mutex> guard(lock);
+      const shared_ptr <const vector <uint64_t> > & cached = cache[prime][inverse];
+      if (cached && cached->size() >= size)
+         return cached;
+   }
+
+   shared_ptr <vector <uint64_t> > table = make_shared <vector <uint64_t> >();
+   rootTable(Montgomery(NTT_PRIMES[prime]), NTT_NONRESIDUES[prime], size,
+             inverse, *table);
+
+   if (keep)
+   {
+      lock_guard <mutex> guard(lock);
+      shared_ptr <const vector <uint64_t> > & cached = cache[prime][inverse];
+      if (!cached || cached->size() < size)
+         cached = table;
+   }
+   return table;
+}
+
+/************************************************
+ * FORWARD MODULO
+ * The transform of a modulo one prime, size long,
+ * in Montgomery form and bit-reversed order
+ ***********************************************/
+static void forwardModulo(int prime, size_t size, const Limb * a, size_t na,
+                          vector <uint64_t> & result)
+{
+   Montgomery field(NTT_PRIMES[prime]);
+   shared_ptr <const vector <uint64_t> > table = roots(prime, size, false);
+
+   result.assign(size, 0);
+   forChunks(na, [&, field](size_t begin, size_t end)
+   {
+      for (size_t i = begin; i < end; i++)
+         result[i] = field.toForm(a[i]);
+   });
+   transformForward(field, &(*table)[0], &result[0], size);
+}
+
+/************************************************
+ * CONVOLVE MODULO
+ * The cyclic convolution of a and b modulo one
+ * prime, in plain (not Montgomery) form. The
+ * transform of b comes from prepared when there
+ * is one, and when b is NULL too this is the
+ * convolution of a with itself.
+ ***********************************************/
+static void convolveModulo(int prime, size_t size,
+                           const Limb * a, size_t na,
+                           const Limb * b, size_t nb,
+                           const vector <uint64_t> * prepared,
+                           vector <uint64_t> & result)
+{
+   Montgomery field(NTT_PRIMES[prime]);
+   forwardModulo(prime, size, a, na, result);
+
+   vector <uint64_t> other;
+   if (b && !prepared)
+   {
+      forwardModulo(prime, size, b, nb, other);
+      prepared = &other;
+   }
+   const vector <uint64_t> & factor = prepared ? *prepared : result;
+   forChunks(size, [&, field](size_t begin, size_t end)
+   {
+      for (size_t i = begin; i < end; i++)
+         result[i] = field.multiply(result[i], factor[i]);
+   });
+
+   shared_ptr <const vector <uint64_t> > table = roots(prime, size, true);
+   transformInverse(field, &(*table)[0], &result[0], size);
+
+   // multiplying a Montgomery form by a plain number leaves a plain
+   // number, so scaling by 1/size also takes us out of the form
+   uint64_t scale = field.fromForm(field.power(field.toForm(size),
+                                               field.p - 2));
+   forChunks(size, [&, field](size_t begin, size_t end)
+   {
+      for (size_t i = begin; i < end; i++)
+         result[i] = field.multiply(result[i], scale);
+   });
+}
+
+/************************************************
+ * WIDE
+ * A 192-bit unsigned number, enough to hold any
+ * value below the product of the three primes
+ ***********************************************/
+struct Wide
+{
+   uint64_t word[3];   // least significant first
+
+   // this += a * b * 2^(64 shift), for a shift of 0 or 1
+   void addProduct(uint64_t a, uint64_t b, int shift)
+   {
+      unsigned __int128 product = (unsigned __int128)a * b;
+      unsigned __int128 sum = (unsigned __int128)word[shift]
+                            + (uint64_t)product;
+      word[shift] = (uint64_t)sum;
+      sum = (unsigned __int128)word[shift + 1] + (uint64_t)(product >> 64)
+          + (uint64_t)(sum >> 64);
+      word[shift + 1] = (uint64_t)sum;
+      if (shift == 0)
+         word[2] += (uint64_t)(sum >> 64);
+   }
+
+   // the low 32 bits, which are shifted out
+   Limb shiftOut()
+   {
+      Limb low = (Limb)word[0];
+      word[0] = (word[0] >> 32) | (word[1] << 32);
+      word[1] = (word[1] >> 32) | (word[2] << 32);
+      word[2] >>= 32;
+      return low;
+   }
+};
+
+/************************************************
+ * NTT FACTOR
+ * A number's transforms modulo each prime, made
+ * once for a number that many others are to be
+ * multiplied by
+ ***********************************************/
+struct NttFactor
+{
+   NttFactor() : size(0), count(0) { }
+
+   size_t size;                            // the transform length, or 0
+   size_t count;                           // limbs in the number
+   vector <uint64_t> residues[NUM_PRIMES];
+};
+
+/************************************************
+ * PREPARE NTT
+ * b's transforms at size, which must be at least
+ * nb plus the limbs of anything it will multiply
+ ***********************************************/
+static void prepareNtt(const Limb * b, size_t nb, size_t size,
+                       NttFactor & factor)
+{
+   factor.size = size;
+   factor.count = nb;
+
+   ThreadPool * pool = parallelPool(size, PARALLEL_NTT_THRESHOLD);
+   TaskGroup group;
+   for (int prime = 0; prime < NUM_PRIMES; prime++)
+      spawn(pool, group, [&, prime]
+      {
+         forwardModulo(prime, size, b, nb, factor.residues[prime]);
+      });
+   if (pool)
+      pool->wait(group);
+}
+
+/************************************************
+ * COMBINE RESIDUES
+ * The first length columns of a product from its
+ * residues, by Garner's method, returning what
+ * carries out of the top. A column is below
+ * min(na, nb) 2^64, far below the product of the
+ * primes, so the result is exact. The columns are
+ * put back together in chunks, each chunk's carry
+ * being added in after.
+ ***********************************************/
+static Wide combineResidues(const vector <uint64_t> * residues, size_t length,
+                            ThreadPool * pool, Limb * product)
+{
+   TaskGroup group;
+
+   // constants for Garner's method, kept in Montgomery form
+   // so that multiplying by them gives plain numbers
+   const uint64_t p0 = NTT_PRIMES[0];
+   const uint64_t p1 = NTT_PRIMES[1];
+   Montgomery field1(p1);
+   Montgomery field2(NTT_PRIMES[2]);
+   uint64_t p0Inverse1 = field1.power(field1.toForm(p0 % p1), p1 - 2);
+   uint64_t p0Mod2 = p0 % field2.p;
+   uint64_t p0p1Mod2 = field2.fromForm(field2.multiply(
+                          field2.toForm(p0Mod2), field2.toForm(p1)));
+   uint64_t p0p1Inverse2 = field2.power(field2.toForm(p0p1Mod2),
+                                        field2.p - 2);
+   unsigned __int128 p0p1 = (unsigned __int128)p0 * p1;
+
+   // each chunk's columns, leaving what it carries past its end
+   size_t chunks = pool ? min((size_t)pool->size() * 4, length / PARALLEL_GRAIN) : 0;
+   chunks = max(chunks, (size_t)1);
+   size_t chunkLength = (length + chunks - 1) / chunks;
+   vector <Wide> carries(chunks);
+   for (size_t c = 0; c < chunks; c++)
+      spawn(pool, group, [&, c, field1, field2]
+      {
+         Wide carry = { { 0, 0, 0 } };
+         size_t end = min(length, (c + 1) * chunkLength);
+         for (size_t i = c * chunkLength; i < end; i++)
+         {
+            // x = r0 + p0 t1 + p0 p1 t2
+            uint64_t r0 = residues[0][i];
+            uint64_t t1 = field1.multiply(field1.subtract(residues[1][i],
+                                                          r0 % p1), p0Inverse1);
+            uint64_t sum = (uint64_t)(((unsigned __int128)p0 * t1 + r0)
+                                      % field2.p);
+            uint64_t t2 = field2.multiply(field2.subtract(residues[2][i], sum),
+                                          p0p1Inverse2);
+
+            carry.addProduct(r0, 1, 0);
+            carry.addProduct(p0, t1, 0);
+            carry.addProduct((uint64_t)p0p1, t2, 0);
+            carry.addProduct((uint64_t)(p0p1 >> 64), t2, 1);
+
+            product[i] = carry.shiftOut();
+         }
+         carries[c] = carry;
+      });
+   if (pool)
+      pool->wait(group);
+
+   // a carry is at most six limbs, and nearly always stops there
+   for (size_t c = 0; c + 1 < chunks; c++)
+   {
+      Limb limbs[6];
+      for (int j = 0; j < 6; j++)
+         limbs[j] = carries[c].shiftOut();
+      size_t at = (c + 1) * chunkLength;
+      addInto(product + at, length - at, limbs, min((size_t)6, length - at));
+   }
+   return carries[chunks - 1];
+}
+
+/************************************************
+ * MULTIPLY NTT
+ * Convolves the limbs modulo three primes and puts
+ * each column back together with the Chinese
+ * remainder theorem. When b is NULL this squares
+ * a, and when prepared is given it stands in for
+ * b and its transforms are used as they are.
+ ***********************************************/
+static void multiplyNtt(const Limb * a, size_t na,
+                        const Limb * b, size_t nb, Limb * product,
+                        const NttFactor * prepared = NULL)
+{
+   size_t length = na + (prepared ? prepared->count : b ? nb : na);
+   size_t size = 1;
+   if (prepared)
+   {
+      assert(prepared->size >= length);
+      size = prepared->size;
+   }
+   while (size < length)
+      size *= 2;
+
+   vector <uint64_t> residues[NUM_PRIMES];
+   ThreadPool * pool = parallelPool(size, PARALLEL_NTT_THRESHOLD);
+   TaskGroup group;
+   for (int prime = 0; prime < NUM_PRIMES; prime++)
+      spawn(pool, group, [&, prime]
+      {
+         convolveModulo(prime, size, a, na, b, nb,
+                        prepared ? &prepared->residues[prime] : NULL,
+                        residues[prime]);
+      });
+   if (pool)
+      pool->wait(group);
+
+   Wide last = combineResidues(residues, length, pool, product);
+   assert(last.word[0] == 0 && last.word[1] == 0 && last.word[2] == 0);
+}
+
+/************************************************
+ * ADD CYCLIC
+ * x = x + term modulo B^size - 1, where x has
+ * size limbs and term no more. What carries out
+ * of the top is worth B^size, which is 1, so it
+ * goes back in at the bottom.
+ ***********************************************/
+static void addCyclic(Limb * x, size_t size, const Limb * term, size_t nTerm)
+{
+   uint64_t carry = 0;
+   for (size_t i = 0; i < size; i++)
+   {
+      carry += x[i];
+      if (i < nTerm)
+         carry += term[i];
+      x[i] = (Limb)carry;
+      carry >>= 32;
+   }
+   for (size_t i = 0; carry && i < size; i++)
+   {
+      carry += x[i];
+      x[i] = (Limb)carry;
+      carry >>= 32;
+   }
+   assert(carry == 0);
+}
+
+/************************************************
+ * MULTIPLY CYCLIC
+ * product = a b modulo B^size - 1, in size limbs,
+ * where size is the length of b's transforms and
+ * a has no more limbs than that. The cyclic
+ * convolution already brings the columns past the
+ * end round to the start; what carries out of the
+ * top comes round after them.
+ ***********************************************/
+static void multiplyCyclic(const Limb * a, size_t na, const NttFactor & b,
+                           Limb * product)
+{
+   size_t size = b.size;
+   assert(na <= size && b.count <= size);
+
+   vector <uint64_t> residues[NUM_PRIMES];
+   ThreadPool * pool = parallelPool(size, PARALLEL_NTT_THRESHOLD);
+   TaskGroup group;
+   for (int prime = 0; prime < NUM_PRIMES; prime++)
+      spawn(pool, group, [&, prime]
+      {
+         convolveModulo(prime, size, a, na, NULL, 0, &b.residues[prime],
+                        residues[prime]);
+      });
+   if (pool)
+      pool->wait(group);
+
+   Wide carry = combineResidues(residues, size, pool, product);
+   Limb limbs[6];
+   for (int j = 0; j < 6; j++)
+      limbs[j] = carry.shiftOut();
+   addCyclic(product, size, limbs, min((size_t)6, size));
+}
+
+/************************************************
+ * MULTIPLY KARATSUBA
+ * Splits each factor into a low and a high half
+ *    a = a1 B^m + a0,  b = b1 B^m + b0
+ * and finds the product from three half-size products:
+ *    z0 = a0 b0,  z2 = a1 b1
+ *    z1 = (a0 + a1)(b0 + b1) - z0 - z2
+ * Writes all na + nb limbs of product. The three
+ * products touch different limbs, so big ones are
+ * worked out at the same time.
+ ***********************************************/
+static void multiplyKaratsuba(const Limb * a, size_t na,
+                              const Limb * b, size_t nb, Limb * product)
+{
+   if (na < nb)
+   {
+      swap(a, b);
+      swap(na, nb);
+   }
+
+   if (nb < KARATSUBA_THRESHOLD)
+   {
+      multiplySchoolbook(a, na, b, nb, product);
+      return;
+   }
+
+   if (nb >= NTT_THRESHOLD)
+   {
+      multiplyNtt(a, na, b, nb, product);
+      return;
+   }
+
+   ThreadPool * pool = parallelPool(nb, PARALLEL_KARATSUBA_THRESHOLD);
+   TaskGroup group;
+
+   // a lopsided product is done as a row of balanced ones, each in its
+   // own piece so they can be found at once and then added in turn
+   if (na >= 2 * nb)
+   {
+      fill(product, product + na + nb, 0);
+      size_t count = (na + nb - 1) / nb;
+      vector <vector <Limb> > pieces(pool ? count : 1, vector <Limb>(2 * nb));
+      for (size_t i = 0; i < count; i++)
+      {
+         size_t offset = i * nb;
+         size_t length = min(nb, na - offset);
+         vector <Limb> & piece = pieces[pool ? i : 0];
+         spawn(pool, group, [&, offset, length]
+         {
+            multiplyKaratsuba(a + offset, length, b, nb, &piece[0]);
+         });
+         if (!pool)
+            addInto(product + offset, na + nb - offset, &piece[0], length + nb);
+      }
+      if (pool)
+      {
+         pool->wait(group);
+         for (size_t i = 0; i < count; i++)
+         {
+            size_t offset = i * nb;
+            size_t length = min(nb, na - offset);
+            addInto(product + offset, na + nb - offset, &pieces[i][0],
+                    length + nb);
+         }
+      }
+      return;
+   }
+
+   // since na < 2 nb, both high halves are non-empty
+   size_t m = na / 2;
+   const Limb * a0 = a;
+   const Limb * a1 = a + m;
+   const Limb * b0 = b;
+   const Limb * b1 = b + m;
+   size_t na1 = na - m;
+   size_t nb1 = nb - m;
+
+   // z0 and z2 go straight into their places in the product
+   spawn(pool, group, [=] { multiplyKaratsuba(a0, m, b0, m, product); });
+   spawn(pool, group, [=]
+   {
+      multiplyKaratsuba(a1, na1, b1, nb1, product + 2 * m);
+   });
+
+   // z1 = (a0 + a1)(b0 + b1) - z0 - z2
+   vector <Limb> sumA(na1 + 1);
+   vector <Limb> sumB(max(m, nb1) + 1);
+   addLimbs(a0, m, a1, na1, &sumA[0]);
+   addLimbs(b0, m, b1, nb1, &sumB[0]);
+
+   vector <Limb> middle(sumA.size() + sumB.size());
+   multiplyKaratsuba(&sumA[0], sumA.size(), &sumB[0], sumB.size(),
+                     &middle[0]);
+   if (pool)
+      pool->wait(group);
+   subtractFrom(&middle[0], middle.size(), product, 2 * m);
+   subtractFrom(&middle[0], middle.size(), product + 2 * m, na1 + nb1);
+
+   // the top limbs of z1 are zero, so only add what fits
+   size_t length = middle.size();
+   while (length > 0 && middle[length - 1] == 0)
+      --length;
+   addInto(product + m, na + nb - m, &middle[0], length);
+}
+
+/************************************************
+ * SQUARE KARATSUBA
+ * Karatsuba for a * a, where every sub-product is
+ * itself a square:
+ *    z1 = (a0 + a1)^2 - a0^2 - a1^2
+ ***********************************************/
+static void squareKaratsuba(const Limb * a, size_t na, Limb * product)
+{
+   if (na < KARATSUBA_SQUARE_THRESHOLD)
+   {
+      squareSchoolbook(a, na, product);
+      return;
+   }
+
+   if (na >= NTT_THRESHOLD)
+   {
+      multiplyNtt(a, na, NULL, 0, product);
+      return;
+   }
+
+   size_t m = na / 2;
+   size_t na1 = na - m;
+
+   ThreadPool * pool = parallelPool(na, PARALLEL_KARATSUBA_THRESHOLD);
+   TaskGroup group;
+   spawn(pool, group, [=] { squareKaratsuba(a, m, product); });
+   spawn(pool, group, [=] { squareKaratsuba(a + m, na1, product + 2 * m); });
+
+   vector <Limb> sum(na1 + 1);
+   addLimbs(a, m, a + m, na1, &sum[0]);
+
+   vector <Limb> middle(2 * sum.size());
+   squareKaratsuba(&sum[0], sum.size(), &middle[0]);
+   if (pool)
+      pool->wait(group);
+   subtractFrom(&middle[0], middle.size(), product, 2 * m);
+   subtractFrom(&middle[0], middle.size(), product + 2 * m, 2 * na1);
+
+   size_t length = middle.size();
+   while (length > 0 && middle[length - 1] == 0)
+      --length;
+   addInto(product + m, 2 * na - m, &middle[0], length);
+}
+
+/************************************************
+ * MULTIPLY LIMBS
+ * product = a * b, picking the method by size.
+ * The product has room for na + nb limbs.
+ ***********************************************/
+void multiplyLimbs(const Limb * a, size_t na, const Limb * b, size_t nb,
+                   Limb * product)
+{
+   if (na == 0 || nb == 0)
+   {
+      fill(product, product + na + nb, 0);
+      return;
+   }
+
+   multiplyKaratsuba(a, na, b, nb, product);
+}
+
+/************************************************
+ * SQUARE LIMBS
+ * product = a * a, picking the method by size.
+ * The product has room for 2 na limbs.
+ ***********************************************/
+void squareLimbs(const Limb * a, size_t na, Limb * product)
+{
+   if (na == 0)
+      return;
+
+   squareKaratsuba(a, na, product);
+}
+
+/************************************************
+ * The conversion to decimal works on vectors of
+ * limbs, least significant first, with no leading
+ * zero limbs. Zero is the empty vector.
+ ***********************************************/
+typedef vector <Limb> Limbs;
+
+/************************************************
+ * TRIM
+ * Drops the leading zero limbs
+ ***********************************************/
+static void trim(Limbs & x)
+{
+   while (!x.empty() && x.back() == 0)
+      x.pop_back();
+}
+
+/************************************************
+ * COMPARE LIMBS
+ * -1, 0 or 1 as a is less than, equal to or
+ * greater than b
+ ***********************************************/
+static int compareLimbs(const Limbs & a, const Limbs & b)
+{
+   if (a.size() != b.size())
+      return a.size() < b.size() ? -1 : 1;
+   for (size_t i = a.size(); i-- > 0; )
+      if (a[i] != b[i])
+         return a[i] < b[i] ? -1 : 1;
+   return 0;
+}
+
+/************************************************
+ * MULTIPLY / ADD / SUBTRACT VECTORS
+ ***********************************************/
+static void multiplyVectors(const Limbs & a, const Limbs & b, Limbs & product)
+{
+   product.assign(a.size() + b.size(), 0);
+   if (!a.empty() && !b.empty())
+      multiplyKaratsuba(&a[0], a.size(), &b[0], b.size(), &product[0]);
+   trim(product);
+}
+
+static void addVectors(Limbs & a, const Limbs & b)
+{
+   if (a.size() < b.size())
+      a.resize(b.size(), 0);
+   a.push_back(0);
+   if (!b.empty())
+      addInto(&a[0], a.size(), &b[0], b.size());
+   trim(a);
+}
+
+static void subtractVectors(Limbs & a, const Limbs & b)
+{
+   assert(compareLimbs(a, b) >= 0);
+   if (!b.empty())
+      subtractFrom(&a[0], a.size(), &b[0], b.size());
+   trim(a);
+}
+
+/************************************************
+ * DIVIDE CHUNK
+ * x = x / 10^9, returning the remainder. With the
+ * divisor fixed, the compiler multiplies by its
+ * reciprocal instead of dividing.
+ ***********************************************/
+static Limb divideChunk(Limbs & x)
+{
+   const uint64_t divisor = 1000000000;
+   uint64_t remainder = 0;
+   for (size_t i = x.size(); i-- > 0; )
+   {
+      uint64_t part = (remainder << 32) | x[i];
+      x[i] = (Limb)(part / divisor);
+      remainder = part % divisor;
+   }
+   trim(x);
+   return (Limb)remainder;
+}
+
+/************************************************
+ * RECIPROCAL
+ * r = floor(B^2m / d), where d has a few limbs
+ * and B = 2^32, by Newton's method:
+ *    x' = x + x (B^2m - d x) / B^2m
+ * starting from a long double and stepping until
+ * it stops moving
+ ***********************************************/
+static void reciprocal(const Limbs & d, Limbs & r)
+{
+   size_t m = d.size();
+   assert(m >= 2);
+
+   // about 30 good bits from the top two limbs of d, on the low side
+   uint64_t top = ((uint64_t)d[m - 1] << 32) | d[m - 2];
+   long double estimate = 79228162514264337593543950336.0L   // 2^96
+                        / ((long double)top + 1.0L) * (1.0L - 1e-9L);
+   uint64_t start = (uint64_t)estimate;
+   r.assign(m - 1, 0);
+   r.push_back((Limb)start);
+   r.push_back((Limb)(start >> 32));
+   trim(r);
+
+   // B^2m
+   Limbs full(2 * m + 1, 0);
+   full[2 * m] = 1;
+
+   Limbs product;
+   Limbs error;
+   Limbs step;
+   Limbs one(1, 1);
+   for (;;)
+   {
+      multiplyVectors(d, r, product);
+      bool below = compareLimbs(product, full) <= 0;
+      if (below)
+      {
+         error = full;
+         subtractVectors(error, product);
+      }
+      else
+      {
+         error = product;
+         subtractVectors(error, full);
+      }
+
+      multiplyVectors(r, error, step);
+      if (step.size() <= 2 * m)
+      {
+         if (below)
+            break;
+         step.clear();
+      }
+      else
+         step.erase(step.begin(), step.begin() + 2 * m);
+
+      // from above, always move at least one
+      if (below)
+         addVectors(r, step);
+      else
+      {
+         addVectors(step, one);
+         subtractVectors(r, step);
+      }
+   }
+
+   // now r is within a few of the answer, on either side
+   multiplyVectors(d, r, product);
+   while (compareLimbs(product, full) > 0)
+   {
+      subtractVectors(r, one);
+      subtractVectors(product, d);
+   }
+   error = full;
+   subtractVectors(error, product);
+   while (compareLimbs(error, d) >= 0)
+   {
+      addVectors(r, one);
+      subtractVectors(error, d);
+   }
+}
+
+/************************************************
+ * POWER LEVEL
+ * 10^(9 2^j) and, for dividing by it, about
+ * B^(2m+G) over it, G being RECIPROCAL_GUARD.
+ * From DECIMAL_NTT_THRESHOLD limbs on, both are
+ * also kept transformed, since every number split
+ * at this level is multiplied by each of them.
+ ***********************************************/
+struct PowerLevel
+{
+   Limbs power;
+   Limbs inverse;
+   NttFactor powerNtt;
+   NttFactor inverseNtt;
+};
+
+/************************************************
+ * MULTIPLY BY FACTOR
+ * product = a b, with b's transforms from factor
+ * when it has them
+ ***********************************************/
+static void multiplyByFactor(const Limbs & a, const Limbs & b,
+                             const NttFactor & factor, Limbs & product)
+{
+   if (factor.size == 0 || a.empty())
+   {
+      multiplyVectors(a, b, product);
+      return;
+   }
+
+   product.assign(a.size() + b.size(), 0);
+   multiplyNtt(&a[0], a.size(), NULL, 0, &product[0], &factor);
+   trim(product);
+}
+
+/************************************************
+ * LEVEL RECIPROCAL
+ * The reciprocal at a level, at most a few below
+ * B^(2m+G) / d. The first level's is exact. Each
+ * one after that starts from the square of the
+ * one below it,
+ *    (B^(2m'+G) / d')^2 = B^(4m'+2G) / d,
+ * which is good to about m' + G of its limbs, and
+ * takes one Newton step:
+ *    r' = r + r (B^(2m+G) - d r) / B^(2m+G)
+ * Stepping from below stays below. What is added
+ * is far smaller than r, so only the top limbs of
+ * r go into it.
+ ***********************************************/
+static void levelReciprocal(const PowerLevel * below, PowerLevel & level)
+{
+   const Limbs & d = level.power;
+   Limbs & r = level.inverse;
+   size_t scale = 2 * d.size() + RECIPROCAL_GUARD;
+
+   if (!below)
+   {
+      // floor(B^2(m+G) / (d B^G))
+      Limbs shifted(RECIPROCAL_GUARD, 0);
+      shifted.insert(shifted.end(), d.begin(), d.end());
+      reciprocal(shifted, r);
+      return;
+   }
+
+   const Limbs & start = below->inverse;
+   r.assign(2 * start.size(), 0);
+   squareKaratsuba(&start[0], start.size(), &r[0]);
+   size_t shift = 2 * (2 * below->power.size() + RECIPROCAL_GUARD) - scale;
+   r.erase(r.begin(), r.begin() + shift);
+   trim(r);
+
+   // B^(2m+G) - d r
+   Limbs error(scale + 1, 0);
+   error[scale] = 1;
+   Limbs product;
+   multiplyVectors(d, r, product);
+   subtractVectors(error, product);
+
+   // each limb of r dropped from the bottom takes less than one off
+   // the step
+   size_t drop = min(r.size(), scale - min(scale, error.size()));
+   Limbs top(r.begin() + drop, r.end());
+   Limbs step;
+   multiplyVectors(top, error, step);
+   if (step.size() > scale - drop)
+   {
+      step.erase(step.begin(), step.begin() + (scale - drop));
+      addVectors(r, step);
+   }
+}
+
+/************************************************
+ * REMAINDER CYCLIC
+ * remainder = x - q d, which must be below
+ * B^size - 1 for the size of d's transforms. Then
+ * it is found from q d modulo B^size - 1 alone,
+ * which takes transforms half as long as the
+ * whole product would.
+ ***********************************************/
+static void remainderCyclic(const Limbs & x, const Limbs & quotient,
+                            const NttFactor & d, Limbs & remainder)
+{
+   size_t size = d.size;
+   assert(x.size() <= 2 * size);
+
+   remainder.assign(x.begin(), x.begin() + min(x.size(), size));
+   remainder.resize(size, 0);
+   if (x.size() > size)
+      addCyclic(&remainder[0], size, &x[size], x.size() - size);
+
+   // -p is B^size - 1 - p, every bit of p flipped
+   Limbs product(size);
+   multiplyCyclic(&quotient[0], quotient.size(), d, &product[0]);
+   for (size_t i = 0; i < size; i++)
+      product[i] = ~product[i];
+   addCyclic(&remainder[0], size, &product[0], size);
+
+   // B^size - 1 is the other way of writing 0
+   size_t i = 0;
+   while (i < size && remainder[i] == 0xffffffff)
+      i++;
+   if (i == size)
+      remainder.clear();
+   trim(remainder);
+}
+
+/************************************************
+ * DIVIDE BY LEVEL
+ * quotient and remainder of x by the power at a
+ * level, where x is below that power squared.
+ * Only the top limbs of x are needed: with r the
+ * level's reciprocal, (x / B^(m-1)) r / B^(m+1+G)
+ * is at most a few below x / d, and so is the
+ * remainder below a few d.
+ ***********************************************/
+static void divideByLevel(const Limbs & x, const PowerLevel & level,
+                          Limbs & quotient, Limbs & remainder)
+{
+   const Limbs & d = level.power;
+   size_t m = d.size();
+
+   if (x.size() < m)
+   {
+      quotient.clear();
+      remainder = x;
+      return;
+   }
+
+   size_t shift = m + 1 + RECIPROCAL_GUARD;
+   Limbs top(x.begin() + (m - 1), x.end());
+   multiplyByFactor(top, level.inverse, level.inverseNtt, quotient);
+   if (quotient.size() <= shift)
+      quotient.clear();
+   else
+      quotient.erase(quotient.begin(), quotient.begin() + shift);
+
+   if (level.powerNtt.size && !quotient.empty())
+      remainderCyclic(x, quotient, level.powerNtt, remainder);
+   else
+   {
+      Limbs product;
+      multiplyVectors(quotient, d, product);
+      remainder = x;
+      subtractVectors(remainder, product);
+   }
+
+   Limbs one(1, 1);
+   while (compareLimbs(remainder, d) >= 0)
+   {
+      subtractVectors(remainder, d);
+      addVectors(quotient, one);
+   }
+}
+
+/************************************************
+ * TO DECIMAL
+ * Writes x, which is below 10^(9 2^j), as exactly
+ * 2^j chunks of nine decimal digits. Big numbers
+ * are split by 10^(9 2^(j-1)) into two halves that
+ * are converted on their own, so the work is a few
+ * fast multiplies per level instead of a quadratic
+ * string of divisions.
+ ***********************************************/
+static void toDecimal(const Limbs & x, size_t j, const vector <PowerLevel> & levels,
+                      uint32_t * chunks)
+{
+   size_t count = (size_t)1 << j;
+
+   if (x.size() <= DECIMAL_THRESHOLD || j == 0)
+   {
+      Limbs rest(x);
+      size_t i = 0;
+      for (; !rest.empty(); i++)
+      {
+         assert(i < count);
+         chunks[i] = divideChunk(rest);
+      }
+      for (; i < count; i++)
+         chunks[i] = 0;
+      return;
+   }
+
+   Limbs high;
+   Limbs low;
+   divideByLevel(x, levels[j - 1], high, low);
+   toDecimal(low,  j - 1, levels, chunks);
+   toDecimal(high, j - 1, levels, chunks + count / 2);
+}
+
+/************************************************
+ * LIMBS TO DECIMAL
+ * Chunks of nine decimal digits, least significant
+ * first, with no leading zero chunks but at least
+ * one chunk
+ ***********************************************/
+void limbsToDecimal(const Limb * x, size_t n, vector <uint32_t> & chunks)
+{
+   Limbs number(x, x + n);
+   trim(number);
+
+   // 10^(9 2^j) > 2^(32 n) once 2^j 9 log2(10) > 32 n
+   size_t j = 0;
+   while (((size_t)1 << j) * 29.89735285398 <= 32.0 * number.size())
+      j++;
+
+   // the powers we split by, each the square of the one before
+   vector <PowerLevel> levels(j);
+   if (j > 0)
+      levels[0].power.assign(1, 1000000000);
+   for (size_t i = 1; i < j; i++)
+   {
+      const Limbs & below = levels[i - 1].power;
+      levels[i].power.assign(2 * below.size(), 0);
+      squareKaratsuba(&below[0], below.size(), &levels[i].power[0]);
+      trim(levels[i].power);
+   }
+
+   // each reciprocal starts from the one below it. The top of a number
+   // and the reciprocal have at most m + 1 and m + 1 + G limbs, and
+   // the remainder needs just over m
+   for (size_t i = 0; i < j; i++)
+   {
+      PowerLevel & level = levels[i];
+      levelReciprocal(i ? &levels[i - 1] : NULL, level);
+
+      size_t m = level.power.size();
+      if (m >= DECIMAL_NTT_THRESHOLD)
+      {
+         size_t size = 1;
+         while (size < 2 * m + 2 + RECIPROCAL_GUARD)
+            size *= 2;
+         prepareNtt(&level.inverse[0], level.inverse.size(), size,
+                    level.inverseNtt);
+         for (size = 1; size < m + 2; size *= 2)
+            ;
+         prepareNtt(&level.power[0], m, size, level.powerNtt);
+      }
+   }
+
+   chunks.assign((size_t)1 << j, 0);
+   toDecimal(number, j, levels, &chunks[0]);
+
+   while (chunks.size() > 1 && chunks.back() == 0)
+      chunks.pop_back();
+}
+
+/************************************************
+ * FROM DECIMAL
+ * The n chunks of nine decimal digits at chunks,
+ * n at most 2^j, as limbs. The low 2^(j-1) chunks
+ * and the rest are converted on their own and
+ * joined with one multiply by 10^(9 2^(j-1)), the
+ * reverse of toDecimal.
+ ***********************************************/
+static void fromDecimal(const uint32_t * chunks, size_t n, size_t j,
+                        const vector <PowerLevel> & levels, Limbs & x)
+{
+   size_t half = j > 0 ? (size_t)1 << (j - 1) : 0;
+   if (j > 0 && n <= half)
+   {
+      fromDecimal(chunks, n, j - 1, levels, x);
+      return;
+   }
+
+   // x = x 10^9 + chunk, from the top chunk down
+   if (n <= DECIMAL_THRESHOLD || j == 0)
+   {
+      x.clear();
+      for (size_t i = n; i-- > 0; )
+      {
+         uint64_t carry = chunks[i];
+         for (size_t k = 0; k < x.size(); k++)
+         {
+            carry += (uint64_t)x[k] * 1000000000;
+            x[k] = (Limb)carry;
+            carry >>= 32;
+         }
+         if (carry)
+            x.push_back((Limb)carry);
+      }
+      return;
+   }
+
+   Limbs high;
+   Limbs low;
+   fromDecimal(chunks + half, n - half, j - 1, levels, high);
+   fromDecimal(chunks, half, j - 1, levels, low);
+   multiplyVectors(high, levels[j - 1].power, x);
+   addVectors(x, low);
+}
+
+/************************************************
+ * DECIMAL TO LIMBS
+ * The inverse of limbsToDecimal
+ ***********************************************/
+void decimalToLimbs(const uint32_t * chunks, size_t n, vector <Limb> & limbs)
+{
+   size_t j = 0;
+   while (((size_t)1 << j) < n)
+      j++;
+
+   // only the powers that split something big are needed
+   vector <PowerLevel> levels(j);
+   if (j > 0)
+      levels[0].power.assign(1, 1000000000);
+   for (size_t i = 1; i < j && ((size_t)1 << i) < n; i++)
+   {
+      const Limbs & below = levels[i - 1].power;
+      levels[i].power.assign(2 * below.size(), 0);
+      squareKaratsuba(&below[0], below.size(), &levels[i].power[0]);
+      trim(levels[i].power);
+   }
+
+   fromDecimal(chunks, n, j, levels, limbs);
+}
+
+/************************************************
+ * PARSE WHOLE NUMBER
+ * Digits, cut into chunks of nine from the right.
+ * Commas may group them as toString does: one to
+ * three digits in front, then exactly three in
+ * every group after.
+ ***********************************************/
+WholeNumber parseWholeNumber(const string & text) throw (const char *)
+{
+   string digits;
+   digits.reserve(text.size());
+   size_t group = 0;        // digits since the last comma
+   bool grouped = false;    // whether there has been a comma
+   for (size_t i = 0; i < text.size(); i++)
+      if (text[i] >= '0' && text[i] <= '9')
+      {
+         digits += text[i];
+         if (++group > 3 && grouped)
+            throw "ERROR: expected a whole number";
+      }
+      else if (text[i] == ',' && group >= 1 && group <= 3 &&
+               (group == 3 || !grouped))
+      {
+         grouped = true;
+         group = 0;
+      }
+      else
+         throw "ERROR: expected a whole number";
+   if (digits.empty() || (grouped && group != 3))
+      throw "ERROR: expected a whole number";
+
+   vector <uint32_t> chunks((digits.size() + 8) / 9, 0);
+   for (size_t c = 0; c < chunks.size(); c++)
+   {
+      size_t end = digits.size() - 9 * c;
+      size_t begin = end > 9 ? end - 9 : 0;
+      uint32_t chunk = 0;
+      for (size_t i = begin; i < end; i++)
+         chunk = chunk * 10 + (digits[i] - '0');
+      chunks[c] = chunk;
+   }
+
+   vector <Limb> limbs;
+   decimalToLimbs(&chunks[0], chunks.size(), limbs);
+   return WholeNumber(WholeNumberView(limbs.empty() ? NULL : &limbs[0],
+                                      limbs.size()));
+}
+
+/************************************************
+ * DIGIT PAIRS
+ * "00" through "99", so the digits of a chunk go
+ * out two at a time
+ ***********************************************/
+static const char DIGIT_PAIRS[] =
+   "0001020304050607080910111213141516171819"
+   "2021222324252627282930313233343536373839"
+   "4041424344454647484950515253545556575859"
+   "6061626364656667686970717273747576777879"
+   "8081828384858687888990919293949596979899";
+
+/************************************************
+ * WRITE GROUP
+ * Three digits, leading zeros and all
+ ***********************************************/
+static inline char * writeGroup(uint32_t group, char * text)
+{
+   *text++ = (char)('0' + group / 100);
+   memcpy(text, DIGIT_PAIRS + 2 * (group % 100), 2);
+   return text + 2;
+}
+
+/************************************************
+ * WRITE PAIR
+ ***********************************************/
+static inline char * writePair(uint32_t pair, char * text)
+{
+   memcpy(text, DIGIT_PAIRS + 2 * pair, 2);
+   return text + 2;
+}
+
+/************************************************
+ * TOP DIGITS
+ * How many digits the top chunk has
+ ***********************************************/
+static size_t topDigits(uint32_t top)
+{
+   size_t digits = 1;
+   for (uint32_t limit = 10; digits < 9 && top >= limit; limit *= 10)
+      digits++;
+   return digits;
+}
+
+/************************************************
+ * FORMATTED LENGTH
+ ***********************************************/
+size_t formattedLength(const uint32_t * chunks, size_t n, DigitFormat format)
+{
+   assert(n > 0);
+   size_t digits = topDigits(chunks[n - 1]);
+   if (format == DIGITS_COMMAS)
+      return digits + (digits - 1) / 3 + (n - 1) * 12;
+   return digits + (n - 1) * 9;
+}
+
+/************************************************
+ * FORMAT DECIMAL
+ * Writes the chunks into text, which must have
+ * room for formattedLength() characters, and
+ * returns the end of what it wrote. Only the top
+ * chunk needs any thought; every one below it is
+ * nine digits, or three groups with a comma in
+ * front of each.
+ ***********************************************/
+char * formatDecimal(const uint32_t * chunks, size_t n, DigitFormat format,
+                     char * text)
+{
+   assert(n > 0);
+
+   // the top chunk, right to left, with no leading zeros
+   uint32_t top = chunks[n - 1];
+   size_t digits = topDigits(top);
+   size_t length = format == DIGITS_COMMAS ? digits + (digits - 1) / 3 : digits;
+   char * end = text + length;
+   for (size_t i = 0; i < digits; i++)
+   {
+      if (format == DIGITS_COMMAS && i > 0 && i % 3 == 0)
+         *--end = ',';
+      *--end = (char)('0' + top % 10);
+      top /= 10;
+   }
+   text += length;
+
+   for (size_t i = n - 1; i-- > 0; )
+   {
+      uint32_t chunk = chunks[i];
+      if (format == DIGITS_COMMAS)
+      {
+         *text++ = ',';
+         text = writeGroup(chunk / 1000000, text);
+         *text++ = ',';
+         text = writeGroup(chunk / 1000 % 1000, text);
+         *text++ = ',';
+         text = writeGroup(chunk % 1000, text);
+      }
+      else
+      {
+         *text++ = (char)('0' + chunk / 100000000);
+         uint32_t rest = chunk % 100000000;
+         text = writePair(rest / 1000000, text);
+         text = writePair(rest / 10000 % 100, text);
+         text = writePair(rest / 100 % 100, text);
+         text = writePair(rest % 100, text);
+      }
+   }
+
+   return text;
+}
+
+/************************************************
+ * HEX LENGTH
+ * Eight digits a limb, less the top limb's
+ * leading zeros
+ ***********************************************/
+size_t hexLength(const Limb * x, size_t n)
+{
+   if (n == 0)
+      return 1;
+   while (n > 1 && x[n - 1] == 0)
+      n--;
+
+   size_t digits = 1;
+   for (Limb top = x[n - 1] >> 4; top; top >>= 4)
+      digits++;
+   return digits + (n - 1) * 8;
+}
+
+/************************************************
+ * FORMAT HEX
+ * Lower case, with no 0x in front
+ ***********************************************/
+char * formatHex(const Limb * x, size_t n, char * text)
+{
+   static const char HEX_DIGITS[] = "0123456789abcdef";
+
+   // an empty view is zero
+   if (n == 0)
+   {
+      *text = '0';
+      return text + 1;
+   }
+
+   size_t length = hexLength(x, n);
+   char * end = text + length;
+   char * digit = end;
+   for (size_t i = 0; digit > text; i++)
+   {
+      Limb limb = x[i];
+      for (int j = 0; j < 8 && digit > text; j++)
+      {
+         *--digit = HEX_DIGITS[limb & 0xf];
+         limb >>= 4;
+      }
+   }
+
+   return end;
+}
@@ -2,7 +2,8 @@
 * Header:
 *    WholeNumber
 * Summary:
-*    This class allows for large integers to be used via nodes.
+*    This class allows for large integers to be used via 32-bit limbs
+*    kept in a contiguous buffer.
 * Author:
 *     Matthew Burr, Shayla Nelson, Bryan Lopez, Kimberly Stowe
 ************************************************************************/
@@ -10,13 +11,108 @@
 #ifndef LARGEINTEGERS_H
 #define LARGEINTEGERS_H
 
-#include "list.h"
+#include "limbBuffer.h"
 #include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
-#include <iomanip>
 #include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
-#define MAXNODES 7
+// one base-2^32 digit of a whole number
+typedef uint32_t Limb;
+
+// the kernels in wholeNumber.cpp. Limbs are least significant first
+void multiplyLimbs(const Limb * a, size_t na, const Limb * b, size_t nb,
+                   Limb * product);
+void squareLimbs(const Limb * a, size_t na, Limb * product);
+
+// x += y over n limbs, returning the carry out of the top. It uses
+// AVX-512 or AVX2 when the processor has them, and for millions of
+// limbs, every thread in the shared pool
+Limb addLimbsOnto(Limb * x, const Limb * y, size_t n);
+
+// from these many limbs on, addOnto hands the sum to addLimbsOnto
+#define VECTOR_ADD_THRESHOLD 16
+
+// chunks of nine decimal digits, least significant first
+void limbsToDecimal(const Limb * x, size_t n, std::vector <uint32_t> & chunks);
+
+// and back again: the limbs of n such chunks
+void decimalToLimbs(const uint32_t * chunks, size_t n, std::vector <Limb> & limbs);
+
+// how the decimal digits are written out
+enum DigitFormat
+{
+   DIGITS_COMMAS,    // 1,234,567
+   DIGITS_PLAIN,     // 1234567
+   DIGITS_HEX        // 12d687, straight from the limbs
+};
+
+// characters needed for those chunks in that format
+size_t formattedLength(const uint32_t * chunks, size_t n, DigitFormat format);
+
+// writes the chunks as text, returning the end of what was written
+char * formatDecimal(const uint32_t * chunks, size_t n, DigitFormat format,
+                     char * text);
+
+// the same for hexadecimal, which needs no conversion
+size_t hexLength(const Limb * x, size_t n);
+char * formatHex(const Limb * x, size_t n, char * text);
+
+/************************************************
+* FORMAT LIMBS
+* All the digits go into one buffer, sized up
+* front, instead of through the stream a few at
+* a time
+***********************************************/
+inline void formatLimbs(const Limb * x, size_t n, DigitFormat format,
+                        std::string & text)
+{
+   if (format == DIGITS_HEX)
+   {
+      text.resize(hexLength(x, n));
+      formatHex(x, n, &text[0]);
+      return;
+   }
+
+   std::vector <uint32_t> chunks;
+   limbsToDecimal(x, n, chunks);
+
+   text.resize(formattedLength(&chunks[0], chunks.size(), format));
+   char * end = formatDecimal(&chunks[0], chunks.size(), format, &text[0]);
+   assert(end == &text[0] + text.size());
+}
+
+/************************************************
+* WHOLENUMBER VIEW
+* Limbs that belong to someone else, such as a
+* mapped file, read where they are. A view can be
+* written out or copied into a WholeNumber, but
+* never changed.
+***********************************************/
+class WholeNumberView
+{
+public:
+   WholeNumberView(const Limb * limbs = NULL, size_t size = 0)
+      : first(limbs), count(size) { }
+
+   const Limb * limbs() const { return first; }
+   size_t size() const        { return count; }
+
+   // the digits as text, as for WholeNumber
+   void toString(std::string & text, DigitFormat format = DIGITS_COMMAS) const
+   {
+      formatLimbs(first, count, format, text);
+   }
+
+private:
+   const Limb * first;
+   size_t count;
+};
 
 /************************************************
 * WHOLENUMBER
@@ -28,40 +124,169 @@ public:
    // default & non-defualt constructors
    WholeNumber(int number = 0)
    {
-      large.push_front(number);
+      assert(number >= 0);
+      large.push_back((Limb)number);
+   }
+
+   // from a 64-bit number
+   explicit WholeNumber(uint64_t number)
+   {
+      large.push_back((Limb)number);
+      if (number >> 32)
+         large.push_back((Limb)(number >> 32));
+   }
+
+#ifdef __SIZEOF_INT128__
+   // from a 128-bit number
+   explicit WholeNumber(unsigned __int128 number)
+   {
+      large.push_back((Limb)number);
+      for (number >>= 32; number; number >>= 32)
+         large.push_back((Limb)number);
    }
+#endif
 
    // copy constructor
    WholeNumber(const WholeNumber & source);
 
+   // a copy of the limbs in a view
+   explicit WholeNumber(const WholeNumberView & view);
+
+   // move constructor: takes the limbs, leaving source as zero. The
+   // moved-from buffer keeps its limbs in place, so the zero cannot
+   // allocate, and std::vector may move whole numbers when it grows
+   WholeNumber(WholeNumber && source) throw ()
+      : large(std::move(source.large))
+   {
+      source.large.push_back(0);
+   }
+
    // assignment operator
    WholeNumber & operator = (const WholeNumber & rhs);
 
+   // move assignment: trades limbs with rhs
+   WholeNumber & operator = (WholeNumber && rhs) throw ()
+   {
+      large.swap(rhs.large);
+      return *this;
+   }
+
+   // exchanges two numbers without copying their limbs
+   void swap(WholeNumber & rhs) throw () { large.swap(rhs.large); }
+
    // displays a LargeInteger
-   void display(std::ostream & out) const;
+   void display(std::ostream & out, DigitFormat format = DIGITS_COMMAS) const;
+
+   // the decimal digits as text, reusing the room already in text
+   void toString(std::string & text, DigitFormat format = DIGITS_COMMAS) const;
 
    // add onto function
    void addOnto(const WholeNumber & term);
 
+   // subtracts a smaller (or equal) number from this one
+   void subtract(const WholeNumber & term) throw (const char *);
+
+   // multiplies this number by another
+   void multiplyBy(const WholeNumber & factor);
+
+   // multiplies this number by itself
+   void square();
+
+   // multiplies this number by a single limb, in place
+   void multiplyByLimb(Limb factor);
+
+   // adds term times a single limb onto this number, in one pass
+   void addMultiple(const WholeNumber & term, Limb factor);
+
+   // divides this number by a single limb, returning the remainder
+   Limb divideByLimb(Limb divisor);
+
+   // -1, 0 or 1 as this number is less than, equal to or greater than rhs
+   int compare(const WholeNumber & rhs) const;
+
+   // is this number zero?
+   bool isZero() const { return large.size() == 1 && large[0] == 0; }
+
+   // the base-2^32 limbs, least significant first, and how many
+   const Limb * limbs() const { return large.limbs(); }
+   size_t size() const        { return large.size();  }
+
+   // those limbs as a view, good until this number changes
+   WholeNumberView view() const { return WholeNumberView(limbs(), size()); }
+
 private:
+   // drops any leading zero limbs, leaving at least one
+   void normalize();
+
+   // numbers of one or two limbs fit in 64 bits, and arithmetic on
+   // two of them takes the short way
+   bool isSmall() const { return large.size() <= 2; }
+   uint64_t small() const
+   {
+      return large.size() == 1 ? large[0] : large[0] | (uint64_t)large[1] << 32;
+   }
+
+   // this = high 2^64 + low, all in the limbs kept in place
+   void setSmall(uint64_t low, uint64_t high = 0)
+   {
+      large.resize(4);
+      large[0] = (Limb)low;
+      large[1] = (Limb)(low >> 32);
+      large[2] = (Limb)high;
+      large[3] = (Limb)(high >> 32);
+      normalize();
+   }
 
-   //variables
-   List <int> large;
+   // base-2^32 limbs, least significant first
+   LimbBuffer <Limb> large;
 };
 
+// a whole number written in decimal, with or without commas
+WholeNumber parseWholeNumber(const std::string & text) throw (const char *);
+
+// a vector of whole numbers must move them, not copy every limb
+static_assert(std::is_nothrow_move_constructible <WholeNumber>::value &&
+              std::is_nothrow_move_assignable <WholeNumber>::value,
+              "whole numbers move without throwing");
+
 /************************************************
 * LARGEINTEGERS :: COPY CONSTRUCTOR
 ***********************************************/
-WholeNumber::WholeNumber(const WholeNumber & source)
+inline WholeNumber::WholeNumber(const WholeNumber & source)
+   : large(source.large)
 {
-   large = source.large;
+}
+
+/************************************************
+* WHOLENUMBER :: VIEW CONSTRUCTOR
+***********************************************/
+inline WholeNumber::WholeNumber(const WholeNumberView & view)
+{
+   if (view.size() == 0)
+      large.push_back(0);
+   else
+   {
+      large.resize(view.size());
+      std::memcpy(large.limbs(), view.limbs(), view.size() * sizeof(Limb));
+      normalize();
+   }
+}
+
+/************************************************
+* WHOLENUMBER :: SWAP
+* Lets std::swap-style code trade the limbs
+* instead of copying them three times
+***********************************************/
+inline void swap(WholeNumber & lhs, WholeNumber & rhs) throw ()
+{
+   lhs.swap(rhs);
 }
 
 /************************************************
 * LARGEINTEGERS :: Insertion Operator
 * Displays the list on the screen
 ***********************************************/
-std::ostream & operator << (std::ostream & out, const WholeNumber & rhs)
+inline std::ostream & operator << (std::ostream & out, const WholeNumber & rhs)
 {
    rhs.display(out);
 
@@ -72,17 +297,80 @@ std::ostream & operator << (std::ostream & out, const WholeNumber & rhs)
 * LARGEINTEGERS :: Add-Onto Operator
 * Adds to whole numbers & puts results in this.
 ***********************************************/
-WholeNumber & operator += (WholeNumber & lhs, const WholeNumber & rhs)
+inline WholeNumber & operator += (WholeNumber & lhs, const WholeNumber & rhs)
 {
    lhs.addOnto(rhs);
    return lhs;
 }
 
+/************************************************
+* WHOLENUMBER :: Subtract Operator
+* Takes a smaller whole number away from this one
+***********************************************/
+inline WholeNumber & operator -= (WholeNumber & lhs, const WholeNumber & rhs)
+{
+   lhs.subtract(rhs);
+   return lhs;
+}
+
+/************************************************
+* WHOLENUMBER :: Multiply Operator
+* Multiplies two whole numbers & puts results in this.
+***********************************************/
+inline WholeNumber & operator *= (WholeNumber & lhs, const WholeNumber & rhs)
+{
+   lhs.multiplyBy(rhs);
+   return lhs;
+}
+
+/************************************************
+* WHOLENUMBER :: Arithmetic Operators
+* The non-modifying versions of the above
+***********************************************/
+inline WholeNumber operator + (const WholeNumber & lhs, const WholeNumber & rhs)
+{
+   WholeNumber sum(lhs);
+   sum += rhs;
+   return sum;
+}
+
+inline WholeNumber operator - (const WholeNumber & lhs, const WholeNumber & rhs)
+{
+   WholeNumber difference(lhs);
+   difference -= rhs;
+   return difference;
+}
+
+inline WholeNumber operator * (const WholeNumber & lhs, const WholeNumber & rhs)
+{
+   WholeNumber product(lhs);
+   product *= rhs;
+   return product;
+}
+
+/************************************************
+* WHOLENUMBER :: Relative Operators
+***********************************************/
+inline bool operator == (const WholeNumber & lhs, const WholeNumber & rhs)
+{
+   return lhs.compare(rhs) == 0;
+}
+
+inline bool operator != (const WholeNumber & lhs, const WholeNumber & rhs)
+{
+   return lhs.compare(rhs) != 0;
+}
+
+inline bool operator < (const WholeNumber & lhs, const WholeNumber & rhs)
+{
+   return lhs.compare(rhs) < 0;
+}
+
 /************************************************
 * LARGEINTEGERS :: Assignment Operator
 * Copies one list to another
 ***********************************************/
-WholeNumber & WholeNumber :: operator = (const WholeNumber & rhs)
+inline WholeNumber & WholeNumber :: operator = (const WholeNumber & rhs)
 {
    large = rhs.large;
    return *this;
@@ -92,22 +380,19 @@ WholeNumber & WholeNumber :: operator = (const WholeNumber & rhs)
 * LARGEINTEGERS :: DISPLAY
 * Writes this large integer to an output stream
 ***********************************************/
-inline void WholeNumber::display(std::ostream & out) const
+inline void WholeNumber::display(std::ostream & out, DigitFormat format) const
 {
-   ListIterator<int> it = large.begin();
-
-   while (it != large.end())
-   {
-      if (it == large.begin())
-         out << *it;
-      else
-         out << std::setw(3) << std::setfill('0') << *it;
-      
-      ++it;
+   std::string text;
+   toString(text, format);
+   out.write(text.data(), text.size());
+}
 
-      if (it != large.end())
-         out << ",";
-   }
+/************************************************
+* WHOLENUMBER :: TO STRING
+***********************************************/
+inline void WholeNumber::toString(std::string & text, DigitFormat format) const
+{
+   formatLimbs(large.limbs(), large.size(), format, text);
 }
 
 /************************************************
@@ -116,50 +401,265 @@ inline void WholeNumber::display(std::ostream & out) const
 ***********************************************/
 inline void WholeNumber::addOnto(const WholeNumber & term)
 {
-   // we need a carry in case the number exceeds the max value that can fit in a node
-   int carry = 0;
-
-   ListIterator<int> myIt = large.rbegin();
-   ListIterator<int> otherIt = term.large.rbegin();
- 
-   while (myIt != large.rend() || otherIt != term.large.rend())
-   {
-      if (otherIt == term.large.rend())
-      {
-         while (myIt != large.rend())
-         {
-            int sum = *myIt + carry;
-            *myIt = sum % 1000;
-            carry = sum / 1000;
-            --myIt;
-         }
-         break;
-      }
-      else if (myIt == term.large.rend())
-      {
-         while (otherIt != term.large.rend())
-         {
-            int sum = *otherIt + carry;
-            large.push_front(sum % 1000);
-            carry = sum / 1000;
-            --otherIt;
-         }
+   if (isSmall() && term.isSmall())
+   {
+      uint64_t x = small();
+      uint64_t sum = x + term.small();
+      setSmall(sum, sum < x);
+      return;
+   }
+
+   // the carry out of a limb rides in the top half of a 64-bit sum
+   uint64_t carry = 0;
+
+   size_t length = term.large.size();
+   if (large.size() < length)
+      large.resize(length);
+
+   // term may be this number, so read its limbs before writing ours
+   const Limb * other = term.large.limbs();
+   Limb * mine = large.limbs();
+
+   size_t i = 0;
+   if (length >= VECTOR_ADD_THRESHOLD)
+   {
+      carry = addLimbsOnto(mine, other, length);
+      i = length;
+   }
+   for (; i < length; i++)
+   {
+      carry += (uint64_t)mine[i] + other[i];
+      mine[i] = (Limb)carry;
+      carry >>= 32;
+   }
+
+   for (; carry && i < large.size(); i++)
+   {
+      carry += mine[i];
+      mine[i] = (Limb)carry;
+      carry >>= 32;
+   }
+
+   if (carry)
+      large.push_back((Limb)carry);
+}
+
+/************************************************
+* WHOLENUMBER :: SUBTRACT
+* Takes one large integer away from this one. Whole
+* numbers cannot go negative, so the term may not be
+* larger than this number.
+***********************************************/
+inline void WholeNumber::subtract(const WholeNumber & term) throw (const char *)
+{
+   if (isSmall() && term.isSmall())
+   {
+      uint64_t x = small();
+      uint64_t y = term.small();
+      if (x < y)
+         throw "ERROR: unable to subtract a larger whole number";
+      setSmall(x - y);
+      return;
+   }
+
+   if (compare(term) < 0)
+      throw "ERROR: unable to subtract a larger whole number";
+
+   // a limb that goes negative wraps around, setting the top bit
+   // of the 64-bit difference, and borrows from the next one
+   Limb borrow = 0;
+
+   size_t length = term.large.size();
+   const Limb * other = term.large.limbs();
+   Limb * mine = large.limbs();
+
+   for (size_t i = 0; i < large.size(); i++)
+   {
+      uint64_t difference = (uint64_t)mine[i] - borrow;
+      if (i < length)
+         difference -= other[i];
+
+      mine[i] = (Limb)difference;
+      borrow = (Limb)(difference >> 63);
+
+      if (i >= length && !borrow)
          break;
-      }
-      else
-      {
-         int sum = *myIt + *otherIt + carry;
-         *myIt = sum % 1000;
-         carry = sum / 1000;
-         --myIt;
-         --otherIt;
-      }
+   }
+
+   assert(borrow == 0);
+   normalize();
+}
+
+/************************************************
+* WHOLENUMBER :: MULTIPLY BY
+* Multiplies this large integer by another. Small
+* numbers use the grade-school method and larger
+* ones Karatsuba or a number-theoretic transform;
+* see wholeNumber.cpp
+***********************************************/
+inline void WholeNumber::multiplyBy(const WholeNumber & factor)
+{
+   if (&factor == this)
+   {
+      square();
+      return;
+   }
+
+#ifdef __SIZEOF_INT128__
+   if (isSmall() && factor.isSmall())
+   {
+      unsigned __int128 product = (unsigned __int128)small() * factor.small();
+      setSmall((uint64_t)product, (uint64_t)(product >> 64));
+      return;
+   }
+#endif
+
+   LimbBuffer <Limb> product;
+   product.resize(large.size() + factor.large.size());
+   multiplyLimbs(large.limbs(), large.size(),
+                 factor.large.limbs(), factor.large.size(),
+                 product.limbs());
+
+   large.swap(product);
+   normalize();
+}
+
+/************************************************
+* WHOLENUMBER :: SQUARE
+* Squaring needs only about half the products of
+* a general multiply
+***********************************************/
+inline void WholeNumber::square()
+{
+#ifdef __SIZEOF_INT128__
+   if (isSmall())
+   {
+      unsigned __int128 product = (unsigned __int128)small() * small();
+      setSmall((uint64_t)product, (uint64_t)(product >> 64));
+      return;
+   }
+#endif
+
+   LimbBuffer <Limb> product;
+   product.resize(2 * large.size());
+   squareLimbs(large.limbs(), large.size(), product.limbs());
+
+   large.swap(product);
+   normalize();
+}
+
+/************************************************
+* WHOLENUMBER :: MULTIPLY BY LIMB
+* One pass with the carry in the top half of a
+* 64-bit product, so no room is needed beyond
+* one more limb
+***********************************************/
+inline void WholeNumber::multiplyByLimb(Limb factor)
+{
+   uint64_t carry = 0;
+   Limb * mine = large.limbs();
+   for (size_t i = 0; i < large.size(); i++)
+   {
+      carry += (uint64_t)mine[i] * factor;
+      mine[i] = (Limb)carry;
+      carry >>= 32;
    }
 
    if (carry)
-      large.push_front(carry);
+      large.push_back((Limb)carry);
+   normalize();
+}
 
-   return;
+/************************************************
+* WHOLENUMBER :: ADD MULTIPLE
+* this += term * factor without building the
+* product. A limb times a limb plus two more
+* limbs still fits in 64 bits.
+***********************************************/
+inline void WholeNumber::addMultiple(const WholeNumber & term, Limb factor)
+{
+   if (factor == 1)
+   {
+      addOnto(term);
+      return;
+   }
+   if (factor == 0 || term.isZero())
+      return;
+
+   size_t length = term.large.size();
+   if (large.size() < length)
+      large.resize(length);
+
+   // term may be this number; each limb is read before it is written
+   const Limb * other = term.large.limbs();
+   Limb * mine = large.limbs();
+
+   uint64_t carry = 0;
+   size_t i = 0;
+   for (; i < length; i++)
+   {
+      carry += (uint64_t)other[i] * factor + mine[i];
+      mine[i] = (Limb)carry;
+      carry >>= 32;
+   }
+
+   for (; carry && i < large.size(); i++)
+   {
+      carry += mine[i];
+      mine[i] = (Limb)carry;
+      carry >>= 32;
+   }
+
+   if (carry)
+      large.push_back((Limb)carry);
+}
+
+/************************************************
+* WHOLENUMBER :: DIVIDE BY LIMB
+* Long division from the top, one limb at a time
+***********************************************/
+inline Limb WholeNumber::divideByLimb(Limb divisor)
+{
+   assert(divisor != 0);
+   uint64_t remainder = 0;
+   Limb * mine = large.limbs();
+   for (size_t i = large.size(); i-- > 0; )
+   {
+      remainder = remainder << 32 | mine[i];
+      mine[i] = (Limb)(remainder / divisor);
+      remainder %= divisor;
+   }
+
+   normalize();
+   return (Limb)remainder;
+}
+
+/************************************************
+* WHOLENUMBER :: COMPARE
+* Compares two normalized large integers
+***********************************************/
+inline int WholeNumber::compare(const WholeNumber & rhs) const
+{
+   if (large.size() != rhs.large.size())
+      return large.size() < rhs.large.size() ? -1 : 1;
+
+   // same number of limbs: the first difference from the top decides
+   for (size_t i = large.size(); i-- > 0; )
+      if (large[i] != rhs.large[i])
+         return large[i] < rhs.large[i] ? -1 : 1;
+
+   return 0;
+}
+
+/************************************************
+* WHOLENUMBER :: NORMALIZE
+* Removes leading zero nodes so that every number
+* has exactly one representation
+***********************************************/
+inline void WholeNumber::normalize()
+{
+   while (large.size() > 1 && large.back() == 0)
+      large.pop_back();
 }
 
-#endif // LARGEINTEGERS_H
\ No newline at end of file
+#endif // LARGEINTEGERS_H